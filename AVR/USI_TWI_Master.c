@@ -34,6 +34,7 @@
 
 unsigned char USI_TWI_Master_Transfer(unsigned char);
 unsigned char USI_TWI_Master_Stop(void);
+static unsigned char USI_TWI_Wait_SCL_High(void);
 
 union USI_TWI_state {
 	unsigned char errorState; // Can reuse the TWI_state for error states due to that it will not be need if there
@@ -136,8 +137,8 @@ __x // AVR compiler
 
 	/* Release SCL to ensure that (repeated) Start can be performed */
 	PORT_USI |= (1 << PIN_USI_SCL); // Release SCL.
-	while (!(PIN_USI & (1 << PIN_USI_SCL)))
-		; // Verify that SCL becomes high.
+	if (!USI_TWI_Wait_SCL_High())   // Verify that SCL becomes high.
+		return (FALSE);
 #ifdef TWI_FAST_MODE
 	DELAY_T4TWI; // Delay for T4TWI if TWI_FAST_MODE
 #else
@@ -169,6 +170,8 @@ __x // AVR compiler
 			/* Clock and verify (N)ACK from slave */
 			DDR_USI &= ~(1 << PIN_USI_SDA); // Enable SDA as input.
 			if (USI_TWI_Master_Transfer(tempUSISR_1bit) & (1 << TWI_NACK_BIT)) {
+				if (USI_TWI_state.errorState == USI_TWI_BUS_TIMEOUT)
+					return (FALSE);
 				if (USI_TWI_state.addressMode)
 					USI_TWI_state.errorState = USI_TWI_NO_ACK_ON_ADDRESS;
 				else
@@ -191,6 +194,8 @@ __x // AVR compiler
 				USIDR = 0x00; // Load ACK. Set data register bit 7 (output for SDA) low.
 			}
 			USI_TWI_Master_Transfer(tempUSISR_1bit); // Generate ACK/NACK.
+			if (USI_TWI_state.errorState == USI_TWI_BUS_TIMEOUT)
+				return (FALSE);
 		}
 	} while (--msgSize); // Until all data sent/received.
 
@@ -200,6 +205,64 @@ __x // AVR compiler
 	return (TRUE);
 }
 
+/*---------------------------------------------------------------
+ Streaming write functions. USI_TWI_Start_Write generates a Start
+ Condition and sends the address byte, then any number of bytes can
+ be sent with USI_TWI_Write_Byte, and USI_TWI_Master_Stop ends the
+ transmission. This allows sending long or generated data without
+ a RAM buffer holding the whole message.
+
+ Both return FALSE if the slave did not ACK, in which case the
+ caller should still call USI_TWI_Master_Stop.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Start_Write(unsigned char address)
+{
+	USI_TWI_state.errorState  = 0;
+	USI_TWI_state.addressMode = TRUE;
+
+	/* Release SCL to ensure that (repeated) Start can be performed */
+	PORT_USI |= (1 << PIN_USI_SCL); // Release SCL.
+	if (!USI_TWI_Wait_SCL_High())   // Verify that SCL becomes high.
+		return (FALSE);
+#ifdef TWI_FAST_MODE
+	DELAY_T4TWI; // Delay for T4TWI if TWI_FAST_MODE
+#else
+	DELAY_T2TWI; // Delay for T2TWI if TWI_STANDARD_MODE
+#endif
+
+	/* Generate Start Condition */
+	PORT_USI &= ~(1 << PIN_USI_SDA); // Force SDA LOW.
+	DELAY_T4TWI;
+	PORT_USI &= ~(1 << PIN_USI_SCL); // Pull SCL LOW.
+	PORT_USI |= (1 << PIN_USI_SDA);  // Release SDA.
+
+	return USI_TWI_Write_Byte(address);
+}
+
+unsigned char USI_TWI_Write_Byte(unsigned char data)
+{
+	unsigned char tempUSISR_8bit = (1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0x0 << USICNT0);
+	unsigned char tempUSISR_1bit = (1 << USISIF) | (1 << USIOIF) | (1 << USIPF) | (1 << USIDC) | (0xE << USICNT0);
+
+	PORT_USI &= ~(1 << PIN_USI_SCL);         // Pull SCL LOW.
+	USIDR = data;                            // Setup data.
+	USI_TWI_Master_Transfer(tempUSISR_8bit); // Send 8 bits on bus.
+
+	/* Clock and verify (N)ACK from slave */
+	DDR_USI &= ~(1 << PIN_USI_SDA); // Enable SDA as input.
+	if (USI_TWI_Master_Transfer(tempUSISR_1bit) & (1 << TWI_NACK_BIT)) {
+		if (USI_TWI_state.errorState == USI_TWI_BUS_TIMEOUT)
+			return (FALSE);
+		if (USI_TWI_state.addressMode)
+			USI_TWI_state.errorState = USI_TWI_NO_ACK_ON_ADDRESS;
+		else
+			USI_TWI_state.errorState = USI_TWI_NO_ACK_ON_DATA;
+		return (FALSE);
+	}
+	USI_TWI_state.addressMode = FALSE;
+	return (TRUE);
+}
+
 /*---------------------------------------------------------------
  Core function for shifting data in and out from the USI.
  Data to be sent has to be placed into the USIDR prior to calling
@@ -216,8 +279,10 @@ unsigned char USI_TWI_Master_Transfer(unsigned char temp)
 	do {
 		DELAY_T2TWI;
 		USICR = temp; // Generate positve SCL edge.
-		while (!(PIN_USI & (1 << PIN_USI_SCL)))
-			; // Wait for SCL to go high.
+		if (!USI_TWI_Wait_SCL_High()) {
+			USIDR = 0xFF; // Read back as a NACK, so the caller stops sending.
+			break;
+		}
 		DELAY_T4TWI;
 		USICR = temp;                   // Generate negative SCL edge.
 	} while (!(USISR & (1 << USIOIF))); // Check for transfer complete.
@@ -238,8 +303,10 @@ unsigned char USI_TWI_Master_Stop(void)
 {
 	PORT_USI &= ~(1 << PIN_USI_SDA); // Pull SDA low.
 	PORT_USI |= (1 << PIN_USI_SCL);  // Release SCL.
-	while (!(PIN_USI & (1 << PIN_USI_SCL)))
-		; // Wait for SCL to go high.
+	if (!USI_TWI_Wait_SCL_High()) {  // Wait for SCL to go high.
+		PORT_USI |= (1 << PIN_USI_SDA);
+		return (FALSE);
+	}
 	DELAY_T4TWI;
 	PORT_USI |= (1 << PIN_USI_SDA); // Release SDA.
 	DELAY_T2TWI;
@@ -254,3 +321,39 @@ unsigned char USI_TWI_Master_Stop(void)
 	return (TRUE);
 }
 
+/*---------------------------------------------------------------
+ Waits for SCL to go high, as a slave may stretch the clock. Gives
+ up after USI_TWI_SCL_TIMEOUT polls so a slave holding SCL low
+ can't hang the program, and sets the error state.
+---------------------------------------------------------------*/
+static inline unsigned char USI_TWI_Wait_SCL_High(void)
+{
+	unsigned char timeout = USI_TWI_SCL_TIMEOUT;
+	while (!(PIN_USI & (1 << PIN_USI_SCL))) {
+		if (--timeout == 0) {
+			USI_TWI_state.errorState = USI_TWI_BUS_TIMEOUT;
+			return (FALSE);
+		}
+	}
+	return (TRUE);
+}
+
+/*---------------------------------------------------------------
+ Function for recovering the bus after a failed transfer. The USI
+ is re-initialised, and SCL is clocked until a slave that was left
+ in the middle of a byte releases SDA, then a Stop Condition is
+ generated. Returns FALSE if SCL is still held low.
+---------------------------------------------------------------*/
+unsigned char USI_TWI_Bus_Recover(void)
+{
+	USI_TWI_Master_Initialise();
+	for (unsigned char i = 0; i < 9 && !(PIN_USI & (1 << PIN_USI_SDA)); i++) {
+		PORT_USI &= ~(1 << PIN_USI_SCL); // Pull SCL LOW.
+		DELAY_T2TWI;
+		PORT_USI |= (1 << PIN_USI_SCL); // Release SCL.
+		if (!USI_TWI_Wait_SCL_High())
+			return (FALSE);
+		DELAY_T4TWI;
+	}
+	return USI_TWI_Master_Stop();
+}
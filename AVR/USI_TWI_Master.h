@@ -34,18 +34,45 @@
 //********** Defines **********//
 // Defines controlling timing limits
 #define TWI_FAST_MODE
+// Fast-mode Plus timing (SCL up to 1MHz). This is outside of the SSD1306 datasheet limit of 400kHz,
+// but most panels handle it. Enable from the makefile with -DTWI_FAST_MODE_PLUS
+//#define TWI_FAST_MODE_PLUS
 
-#define SYS_CLK 8000.0 // [kHz]
+#define SYS_CLK (F_CPU / 1000.0) // [kHz]
 
-#ifdef TWI_FAST_MODE                            // TWI FAST mode timing limits. SCL = 100-400kHz
-#define T2_TWI ((SYS_CLK * 1300) / 1000000) + 1 // >1,3us
-#define T4_TWI ((SYS_CLK * 600) / 1000000) + 1  // >0,6us
+#if defined(TWI_FAST_MODE_PLUS)                 // TWI FAST mode plus timing limits. SCL <= 1MHz
+#define T2_TWI_NS 500                           // >0,5us
+#define T4_TWI_NS 500                           // >0,26us, stretched so SCL stays <= 1MHz
+
+#elif defined(TWI_FAST_MODE)                    // TWI FAST mode timing limits. SCL = 100-400kHz
+#define T2_TWI_NS 1300                          // >1,3us
+#define T4_TWI_NS 1200                          // >0,6us, stretched so SCL stays <= 400kHz
 
 #else                                           // TWI STANDARD mode timing limits. SCL <= 100kHz
-#define T2_TWI ((SYS_CLK * 4700) / 1000000) + 1 // >4,7us
-#define T4_TWI ((SYS_CLK * 4000) / 1000000) + 1 // >4,0us
+#define T2_TWI_NS 4700                          // >4,7us
+#define T4_TWI_NS 5300                          // >4,0us, stretched so SCL stays <= 100kHz
 #endif
 
+#define T2_TWI ((unsigned long)((SYS_CLK * T2_TWI_NS) / 1000000) + 1)
+#define T4_TWI ((unsigned long)((SYS_CLK * T4_TWI_NS) / 1000000) + 1)
+
+// Cycles spent in USI_TWI_Master_Transfer's clock loop around each delay, which already count towards
+// the SCL low (T2) and high (T4) periods. These are the fewest cycles the loop can compile to, not the
+// typical count, so inlining or a different compiler can only make the periods longer:
+//  low:  after SCL drops, the sbis/rjmp on USIOIF back to the loop top (1+2) and the out that raises
+//        SCL (1) = 4
+//  high: after SCL rises, the SCL poll that skips once SCL reads high (2) and the out that drops
+//        SCL (1) = 3
+// At 8MHz in Fast mode this gives at least 7+4 = 11 cycles (1.375us) low and 7+3 = 10 cycles (1.25us) high
+#define T2_TWI_OVERHEAD 4
+#define T4_TWI_OVERHEAD 3
+#define T2_TWI_CYCLES (T2_TWI > T2_TWI_OVERHEAD ? T2_TWI - T2_TWI_OVERHEAD : 0)
+#define T4_TWI_CYCLES (T4_TWI > T4_TWI_OVERHEAD ? T4_TWI - T4_TWI_OVERHEAD : 0)
+
+// How many times to poll SCL while waiting for a slave to release it before giving up, so a stuck
+// slave can't hang the program. Each poll is a few cycles, so this is well over 100us
+#define USI_TWI_SCL_TIMEOUT 255
+
 // Defines controling code generating
 //#define PARAM_VERIFICATION
 //#define NOISE_TESTING
@@ -70,6 +97,7 @@
 #define USI_TWI_NO_ACK_ON_ADDRESS 0x06 // The slave did not acknowledge  the address
 #define USI_TWI_MISSING_START_CON 0x07 // Generated Start Condition not detected on bus
 #define USI_TWI_MISSING_STOP_CON 0x08  // Generated Stop Condition not detected on bus
+#define USI_TWI_BUS_TIMEOUT 0x09       // SCL was held low by a slave for too long
 
 // Device dependant defines
 #define DDR_USI DDRB
@@ -86,11 +114,11 @@
 #define FALSE 0
 
 #if __GNUC__
-#define DELAY_T2TWI (_delay_us(T2_TWI / 4))
-#define DELAY_T4TWI (_delay_us(T4_TWI / 4))
+#define DELAY_T2TWI (__builtin_avr_delay_cycles(T2_TWI_CYCLES))
+#define DELAY_T4TWI (__builtin_avr_delay_cycles(T4_TWI_CYCLES))
 #else
-#define DELAY_T2TWI (__delay_cycles(T2_TWI))
-#define DELAY_T4TWI (__delay_cycles(T4_TWI))
+#define DELAY_T2TWI (__delay_cycles(T2_TWI_CYCLES))
+#define DELAY_T4TWI (__delay_cycles(T4_TWI_CYCLES))
 #endif
 //********** Prototypes **********//
 
@@ -102,3 +130,9 @@ __x // AVR compiler
     USI_TWI_Start_Transceiver_With_Data(unsigned char *, unsigned char);
 
 unsigned char USI_TWI_Get_State_Info(void);
+
+// Streaming write, for sending data without having it all in a buffer first
+unsigned char USI_TWI_Start_Write(unsigned char);
+unsigned char USI_TWI_Write_Byte(unsigned char);
+unsigned char USI_TWI_Master_Stop(void);
+unsigned char USI_TWI_Bus_Recover(void);
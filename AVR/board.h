@@ -0,0 +1,44 @@
+/**
+ * Camera Shutter Control Project, board pin definitions
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef BOARD_H
+#define BOARD_H
+
+#include <avr/io.h>
+
+/* LED Related Macros */
+#define LED_PORT PORTB
+#ifdef FLASH_SYNC
+#define LED_RED_PIN 0           // PB1 is the flash-sync input instead
+#elif defined(TELEMETRY)
+#define LED_RED_PIN 0           // PB1 is the telemetry output instead
+#else
+#define LED_RED_PIN (1 << 1)
+#endif
+#define LED_GREEN_PIN (1 << 3)
+#define LED_BLUE_PIN (1 << 5)
+#define TURN_ON_RED_LED (LED_PORT &= ~LED_RED_PIN)
+#define TURN_ON_GREEN_LED (LED_PORT &= ~LED_GREEN_PIN)
+#define TURN_ON_BLUE_LED (LED_PORT &= ~LED_BLUE_PIN)
+#define TURN_OFF_RED_LED (LED_PORT |= LED_RED_PIN)
+#define TURN_OFF_GREEN_LED (LED_PORT |= LED_GREEN_PIN)
+#define TURN_OFF_BLUE_LED (LED_PORT |= LED_BLUE_PIN)
+#define TURN_OFF_ALL_LED TURN_OFF_RED_LED; TURN_OFF_GREEN_LED; TURN_OFF_BLUE_LED
+#define TURN_ON_CYAN TURN_ON_GREEN_LED; TURN_ON_BLUE_LED
+/* Rotary Encoder and Button Read Macros */
+#define READ_ROTARY_ENCODER_BIT ((PINA >> 6) & 0b11)
+#define READ_ROTARY_ENCODER_BUTTON ((PINB >> 4) & 0b1)
+#define READ_TRIGGER_BUTTON ((PINA >> 2) & 0b1)
+#define READ_MODE_BUTTON ((PINA >> 3) & 0b1)
+/* Trigger Related Macros, channel 0 is on PA0 and channel 1 on PA1 */
+#define TRIGGER_PIN(channel) (1 << (channel))
+#define TRIGGER_ON(pins) PORTA |= (pins)
+#define TRIGGER_OFF(pins) PORTA &= ~(pins)
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * Camera Shutter Control Project, button debouncing
+ * By Electro707, 2023
+ *
+ * The buttons are debounced with a 2-bit vertical counter per button, run from the timer tick. A button
+ * has to read the same for 4 ticks in a row (32ms) for its debounced state to change, which then
+ * generates a press or release event. Holding a button for BUTTON_LONG_TICKS also generates a long press.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "board.h"
+#include "buttons.h"
+
+static uint8_t ct0 = 0xFF, ct1 = 0xFF;     // vertical counter bits
+static uint8_t state = 0;                   // debounced state, 1 is pressed
+static uint8_t long_count = 0;              // ticks the buttons have been held unchanged for
+static volatile uint8_t press = 0;
+static volatile uint8_t release = 0;
+static volatile uint8_t long_press = 0;
+
+/**
+ * Reads the buttons, with pressed as 1
+ */
+static inline uint8_t buttons_read(void){
+    uint8_t raw = 0;
+    if(READ_MODE_BUTTON == 0){raw |= BUTTON_MODE;}
+    if(READ_TRIGGER_BUTTON == 0){raw |= BUTTON_TRIGGER;}
+    if(READ_ROTARY_ENCODER_BUTTON == 1){raw |= BUTTON_ENCODER;}
+    return raw;
+}
+
+/**
+ * Gets called from the timer ISR on every tick. Returns the buttons that changed state or got long
+ * pressed this tick
+ */
+uint8_t buttons_tick(void){
+    uint8_t changed = state ^ buttons_read();
+
+    // count up the buttons that differ from the debounced state, and reset the ones that don't
+    ct0 = ~(ct0 & changed);
+    ct1 = ct0 ^ (ct1 & changed);
+    changed &= ct0 & ct1;       // buttons whose counter rolled over
+    state ^= changed;
+    press |= state & changed;
+    release |= ~state & changed;
+
+    if(changed){
+        long_count = 0;
+    } else if(state && long_count != 0xFF && ++long_count == BUTTON_LONG_TICKS){
+        long_press |= state;
+        changed = state;
+    }
+    return changed;
+}
+
+static uint8_t get_and_clear(volatile uint8_t *events, uint8_t mask){
+    uint8_t ret;
+    cli();
+    ret = *events & mask;
+    *events &= ~mask;
+    sei();
+    return ret;
+}
+
+uint8_t buttons_get_press(uint8_t mask){
+    return get_and_clear(&press, mask);
+}
+
+uint8_t buttons_get_release(uint8_t mask){
+    return get_and_clear(&release, mask);
+}
+
+uint8_t buttons_get_long(uint8_t mask){
+    return get_and_clear(&long_press, mask);
+}
+
+/**
+ * Returns the debounced state of the buttons
+ */
+uint8_t buttons_state(void){
+    return state;
+}
@@ -0,0 +1,27 @@
+/**
+ * Camera Shutter Control Project, button debouncing
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef BUTTONS_H
+#define BUTTONS_H
+
+#include <avr/io.h>
+
+#define BUTTON_MODE     (1 << 0)
+#define BUTTON_TRIGGER  (1 << 1)
+#define BUTTON_ENCODER  (1 << 2)
+
+#define BUTTON_LONG_TICKS 125       // how long a button has to be held down for a long press, in ticks
+
+uint8_t buttons_tick(void);
+uint8_t buttons_get_press(uint8_t mask);
+uint8_t buttons_get_release(uint8_t mask);
+uint8_t buttons_get_long(uint8_t mask);
+uint8_t buttons_state(void);
+
+#endif
@@ -0,0 +1,101 @@
+/**
+ * Camera Shutter Control Project, power-down between active windows
+ * By Electro707, 2023
+ *
+ * This puts the MCU in power-down while a sequence waits for its start or next active window, using the
+ * watchdog as the wake-up timer. The watchdog keeps its reset, so it still resets the MCU if the main
+ * loop hangs: the interrupt only gets re-enabled from the main loop after each wake-up.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include <avr/wdt.h>
+#include "deepsleep.h"
+#include "recovery.h"
+#include "trim.h"
+
+// WDTCR prescaler bits of the watchdog timeout
+#define WDT_PRESCALER ((RECOVERY_WDT_TIMEOUT & 0x07) | ((RECOVERY_WDT_TIMEOUT & 0x08) ? (1 << WDP3) : 0))
+
+static volatile uint8_t wdt_woke = 0;
+static volatile uint16_t wdt_counts;    // TIMER0 count at the last watchdog interrupt
+
+/**
+ * Sleeps in the current sleep mode until the next watchdog interrupt
+ *
+ * Only the interrupt enable gets set again, the watchdog itself isn't reset, so the interrupts keep
+ * coming exactly one watchdog period apart no matter how long the MCU was awake in between
+ */
+static void wdt_sleep(void){
+    cli();
+    wdt_woke = 0;
+    WDTCR |= (1 << WDIE);
+    while(!wdt_woke){
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+        cli();
+    }
+    sei();
+}
+
+/**
+ * Measures the watchdog period in TIMER0 counts, as they are without the trim, and leaves the watchdog
+ * interrupt running
+ *
+ * Takes two watchdog periods, with TIMER0 running. This returns right after a watchdog interrupt, so
+ * the time since the last second counted by TIMER0 is where the watchdog takes over the counting
+ */
+uint16_t deepsleep_calibrate(void){
+    uint16_t start_counts;
+    uint8_t sreg = SREG;
+
+    // the interrupt fires once before the watchdog would reset the MCU
+    cli();
+    wdt_reset();
+    WDTCR = (1 << WDCE) | (1 << WDE);
+    WDTCR = (1 << WDE) | WDT_PRESCALER;
+    SREG = sreg;
+
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    wdt_sleep();
+    start_counts = wdt_counts;
+    wdt_sleep();
+
+    return wdt_counts - start_counts;
+}
+
+/**
+ * Gets ready to power down, the TIMER0 interrupt has to be disabled by the caller first
+ */
+void deepsleep_start(void){
+    ADCSRA &= ~(1 << ADEN);      // the ADC would keep drawing current
+    set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+}
+
+/**
+ * Powers down until the next watchdog interrupt. Pin changes wake the MCU up too, but it goes straight
+ * back to sleep
+ */
+void deepsleep_wait(void){
+    wdt_sleep();
+}
+
+/**
+ * Goes back to the watchdog only being used for resets
+ */
+void deepsleep_end(void){
+    wdt_enable(RECOVERY_WDT_TIMEOUT);
+    ADCSRA |= (1 << ADEN) | (1 << ADSC);
+}
+
+ISR(WDT_vect){
+    wdt_counts = trim_counts();
+    wdt_woke = 1;
+}
@@ -0,0 +1,36 @@
+/**
+ * Camera Shutter Control Project, power-down between active windows
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef DEEPSLEEP_H
+#define DEEPSLEEP_H
+
+#include <avr/io.h>
+
+/**
+ * While powered down, Timer0 is stopped and time is kept by the watchdog instead, which wakes the MCU up
+ * about once a second. The watchdog oscillator is only accurate to about 10%, so its period is measured
+ * against Timer0 first, and the measured length of each wake-up is added up into whole seconds.
+ *
+ * Power-down is left this many seconds before the window opens, so the pictures are timed by Timer0.
+ */
+#define DEEPSLEEP_RESYNC_SECONDS 4
+
+/**
+ * The time asleep is added up in 1/32 of a Timer0 count, which makes a second 1000000 of them at the
+ * nominal clock. The clock trim gets added to that in ppm, so it holds while powered down too
+ */
+#define DEEPSLEEP_UNITS_PER_COUNT 32
+#define DEEPSLEEP_UNITS_PER_SECOND 1000000L
+
+uint16_t deepsleep_calibrate(void);
+void deepsleep_start(void);
+void deepsleep_wait(void);
+void deepsleep_end(void);
+
+#endif
@@ -0,0 +1,35 @@
+/**
+ * Camera Shutter Control Project, rotary encoder decoding
+ * By Electro707, 2023
+ *
+ * This turns the sampled encoder pins into steps. It doesn't touch any registers and keeps its state in
+ * the caller's variable, so the same code can be fed pin samples recorded with the telemetry stream
+ * (see TELEMETRY_ENCODER) to check a change against them.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include "encoder.h"
+
+/**
+ * Takes the next sample of the two encoder pins, and returns the step it completes if any
+ *
+ * pvcv holds the previous and the current sample, as 0bXXYY. Only the transitions that land on a detent
+ * (with both pins the same) count, which gives one step per detent
+ */
+RotaryEncoderRotation_e encoder_decode(uint8_t *pvcv, uint8_t pins){
+    *pvcv = ((*pvcv << 2) | pins) & 0x0F;
+
+    switch(*pvcv){
+        case 0b1000:
+        case 0b0111:
+            return ROTARY_ENCODER_ROT_CW;
+        case 0b0100:
+        case 0b1011:
+            return ROTARY_ENCODER_ROT_CCW;
+    }
+    return ROTARY_ENCODER_ROT_NOTHING;
+}
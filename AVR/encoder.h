@@ -0,0 +1,23 @@
+/**
+ * Camera Shutter Control Project, rotary encoder decoding
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <avr/io.h>
+
+typedef enum{
+    ROTARY_ENCODER_ROT_NOTHING = 0,
+    ROTARY_ENCODER_ROT_CW = 1,
+    ROTARY_ENCODER_ROT_CCW = 2,
+}RotaryEncoderRotation_e;
+
+RotaryEncoderRotation_e encoder_decode(uint8_t *pvcv, uint8_t pins);
+
+#endif
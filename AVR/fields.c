@@ -0,0 +1,57 @@
+/**
+ * Camera Shutter Control Project, settings fields
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include "fields.h"
+#include "trim.h"
+#include "ir.h"
+
+const char label_trt[] PROGMEM = "Shutter Speed:";
+const char label_tt[] PROGMEM = "T- Trigger:";
+const char label_npic[] PROGMEM = "# Pics:";
+const char label_interv[] PROGMEM = "Interv:";
+const char label_start[] PROGMEM = "Start in:";
+const char label_window[] PROGMEM = "Window:";
+#ifdef IR_REMOTE
+const char label_ir[] PROGMEM = "IR:";
+#endif
+
+/**
+ * The settings fields, in the order the mode button cycles through them
+ */
+const MenuField_s menu_fields[] PROGMEM = {
+    {label_trt, &channels[0].cur.trt, 1, MENU_HMS_MAX, 1, 0, 0, MENU_FORMAT_HMS},
+    {label_tt, &channels[0].cur.tt, 0, MENU_HMS_MAX, 3, 0, 0, MENU_FORMAT_HMS},
+    {label_npic, &channels[0].cur.n_pic, 0, MENU_NUMBER_MAX, 5, 0, 0, MENU_FORMAT_NUMBER},
+    {label_interv, &channels[0].cur.tmlps_interv, 0, MENU_HMS_MAX, 5, 64, 0, MENU_FORMAT_HMS},
+    {label_start, &channels[0].cur.start_delay, 0, MENU_HMS_MAX, 7, 0, 0, MENU_FORMAT_HMS},
+    {label_window, &channels[0].cur.window, 0, TRIGGER_WINDOW_PERIOD-1, 7, 64, 0, MENU_FORMAT_HMS},
+#ifdef IR_REMOTE
+    {label_ir, &ir_protocol, IR_PROTOCOL_OFF, IR_N_PROTOCOLS-1, 3, 78, 0, MENU_FORMAT_NUMBER},
+#endif
+};
+
+/**
+ * The settings of the second channel, which uses the start delay and window of the first. A shutter
+ * time of 0 leaves its line driven along with the first channel
+ */
+const MenuField_s channel2_fields[] PROGMEM = {
+    {label_trt, &channels[1].cur.trt, 0, MENU_HMS_MAX, 1, 0, 0, MENU_FORMAT_HMS},
+    {label_tt, &channels[1].cur.tt, 0, MENU_HMS_MAX, 3, 0, 0, MENU_FORMAT_HMS},
+    {label_npic, &channels[1].cur.n_pic, 0, MENU_NUMBER_MAX, 5, 0, 0, MENU_FORMAT_NUMBER},
+    {label_interv, &channels[1].cur.tmlps_interv, 0, MENU_HMS_MAX, 5, 64, 0, MENU_FORMAT_HMS},
+};
+
+const char label_trim[] PROGMEM = "Trim ppm:";
+
+/**
+ * The only field of the clock trim page
+ */
+const MenuField_s trim_fields[] PROGMEM = {
+    {label_trim, &trim_ppm, -TRIM_PPM_MAX, TRIM_PPM_MAX, 2, 0, 0, MENU_FORMAT_SIGNED},
+};
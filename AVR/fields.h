@@ -0,0 +1,36 @@
+/**
+ * Camera Shutter Control Project, settings fields
+ * By Electro707, 2023
+ *
+ * The labels and field tables of the settings pages. They are in their own file so the host screen
+ * test draws the same ones as the firmware, and layout_gen.py reads the main settings screen from here.
+ * The field counts are part of the declarations, so a table that doesn't match them doesn't build
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef FIELDS_H
+#define FIELDS_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include "menu.h"
+#include "trigger.h"
+
+#ifdef IR_REMOTE
+#define MENU_N_FIELDS 7
+#else
+#define MENU_N_FIELDS 6
+#endif
+#define CHANNEL2_N_FIELDS 4
+#define TRIM_N_FIELDS 1
+
+extern TriggerChannel_s channels[TRIGGER_N_CHANNELS];      // the settings being edited, in main.c
+
+extern const MenuField_s menu_fields[MENU_N_FIELDS] PROGMEM;
+extern const MenuField_s channel2_fields[CHANNEL2_N_FIELDS] PROGMEM;
+extern const MenuField_s trim_fields[TRIM_N_FIELDS] PROGMEM;
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * Camera Shutter Control Project, flash-sync feedback
+ * By Electro707, 2023
+ *
+ * This times the camera's flash-sync contact against the shutter line, and drives the adaptive
+ * interval: with the interval set to 0, the next picture is started as soon as the camera can take it.
+ * A picture the camera didn't take, which shows up as no flash-sync while the shutter line was held,
+ * is taken again after waiting a second longer than before. After a few pictures in a row go through,
+ * a second shorter wait is tried again, so the wait settles on the shortest one that works.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "flashsync.h"
+#include "oled.h"
+#include "menu.h"
+#include "scheduler.h"
+
+#ifdef FLASH_SYNC
+
+#ifdef TELEMETRY
+#error "FLASH_SYNC and TELEMETRY both use PB1"
+#endif
+
+static volatile bool closed = false;        // last state of the contact
+static volatile bool armed = false;         // the shutter line is pressed, and the contact hasn't closed yet
+static volatile bool seen = false;          // the contact closed while the shutter line was pressed
+static uint16_t mark_ticks;                 // time of the last shutter press or contact closing
+static uint8_t mark_tcnt;
+static volatile uint32_t lag = 0;           // shutter lag of the last picture, in TIMER0 counts
+static volatile uint32_t exposure = 0;      // exposure of the last picture, in TIMER0 counts
+
+static bool connected;                      // the camera's flash-sync showed up during this sequence
+static uint8_t wait;                        // seconds waited between pictures with the adaptive interval
+static uint8_t streak;                      // pictures taken in a row at this wait
+
+void flashsync_init(void){
+    DDRB &= ~FLASHSYNC_PIN;
+    PORTB |= FLASHSYNC_PIN;         // pull-up, the contact shorts it to ground
+    PCMSK1 |= (1 << PCINT9);        // main clears the rest of the mask, which would include the I2C lines
+    GIMSK |= (1 << PCIE0);
+}
+
+/**
+ * Marks the time, in TIMER0 ticks and counts
+ */
+static void mark_time(void){
+    mark_tcnt = TCNT0L;
+    mark_ticks = tick_count;
+    // when called from another ISR, the tick that just started may not have been counted yet
+    if((TIFR & (1 << OCF0A)) && mark_tcnt < 128){
+        mark_ticks++;
+    }
+}
+
+/**
+ * Returns how long ago the last mark was, in TIMER0 counts
+ */
+static uint32_t since_mark(void){
+    uint16_t ticks = mark_ticks;
+    uint8_t tcnt = mark_tcnt;
+
+    mark_time();
+    // each tick is 250 TIMER0 counts
+    return (uint32_t)(uint16_t)(mark_ticks - ticks) * 250 + (int16_t)(mark_tcnt - tcnt);
+}
+
+/**
+ * Starts a sequence, called when arming. Until the first picture shows up on the flash-sync, it is
+ * taken that nothing is connected and the pictures are taken blindly
+ */
+void flashsync_start(void){
+    connected = false;
+    wait = 0;
+    streak = 0;
+}
+
+/**
+ * Gets called from the timer ISR when the shutter line gets pressed
+ */
+void flashsync_arm(void){
+    mark_time();
+    seen = false;
+    armed = true;
+}
+
+/**
+ * Gets called from the pin change ISR, which is shared with the rotary encoder
+ */
+void flashsync_edge(void){
+    bool now = FLASHSYNC_CLOSED;
+
+    if(now == closed){
+        return;
+    }
+    closed = now;
+    if(closed && armed){
+        lag = since_mark();
+        armed = false;
+        seen = true;
+    } else if(!closed && seen){
+        exposure = since_mark();
+    }
+}
+
+/**
+ * Called from the timer ISR when the shutter line of an adaptive interval picture gets released. Sets
+ * the wait until the next picture, and returns true if the camera didn't take this one
+ */
+bool flashsync_missed(int32_t *interval){
+    bool missed = !seen;
+
+    armed = false;
+    if(!missed){
+        connected = true;
+        if(++streak >= FLASHSYNC_PROBE_SHOTS && wait != 0){
+            wait--;
+            streak = 0;
+        }
+    } else if(connected){
+        streak = 0;
+        if(wait < FLASHSYNC_MAX_WAIT){
+            wait++;
+        } else {
+            // the camera isn't taking pictures anymore at all, carry on instead of retrying forever
+            missed = false;
+        }
+    } else {
+        missed = false;
+    }
+    *interval = wait;
+    return missed;
+}
+
+/**
+ * Draws the shutter lag and exposure of the last picture, in ms
+ */
+void flashsync_draw(uint8_t line){
+    char text[MENU_TEXT_SIZE];
+    uint32_t ms;
+
+    oled_send_text_P(PSTR("Lag"), line);
+    cli();
+    ms = lag;
+    sei();
+    menu_format((ms * 4) / 125, MENU_FORMAT_NUMBER, 0xFF, text);   // 32us counts
+    oled_send_chars(text, line, 4*6, 0xFF);
+
+    oled_send_chars_P(PSTR("Exp"), line, 10*6);
+    cli();
+    ms = exposure;
+    sei();
+    menu_format((ms * 4) / 125, MENU_FORMAT_NUMBER, 0xFF, text);
+    oled_send_chars(text, line, 14*6, 0xFF);
+}
+
+#endif
@@ -0,0 +1,56 @@
+/**
+ * Camera Shutter Control Project, flash-sync feedback
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef FLASHSYNC_H
+#define FLASHSYNC_H
+
+#include <avr/io.h>
+#include <stdbool.h>
+
+/**
+ * The flash-sync contact of the camera (the center pin of the hot-shoe, or a PC-sync cable) goes on
+ * PB1, which is the PROG_MISO pin on the ISP header (J2), and its ground on the header's ground. The
+ * camera shorts the contact while the shutter is fully open, so the time from pressing the shutter line
+ * until it closes is the shutter lag, and how long it stays closed is the exposure.
+ *
+ * PB1 also drives the red rotary encoder LED, which is left off, and the telemetry stream, so this
+ * can't be used along with TELEMETRY.
+ */
+#define FLASHSYNC_PIN (1 << 1)
+#define FLASHSYNC_CLOSED ((PINB & FLASHSYNC_PIN) == 0)
+
+#define FLASHSYNC_MAX_WAIT 60       // longest the adaptive interval backs off to, in seconds
+#define FLASHSYNC_PROBE_SHOTS 8     // pictures in a row that have to be taken before a shorter wait is tried
+
+#ifdef FLASH_SYNC
+void flashsync_init(void);
+void flashsync_start(void);
+void flashsync_arm(void);
+void flashsync_edge(void);
+bool flashsync_missed(int32_t *interval);
+void flashsync_draw(uint8_t line);
+
+#define FLASHSYNC_INIT() flashsync_init()
+#define FLASHSYNC_START() flashsync_start()
+#define FLASHSYNC_ARM() flashsync_arm()
+#define FLASHSYNC_EDGE() flashsync_edge()
+#define FLASHSYNC_ADAPTIVE(interval) ((interval) == 0)       // an interval of 0 adapts to the camera
+#define FLASHSYNC_MISSED(interval) flashsync_missed(interval)
+#define FLASHSYNC_DRAW(line) flashsync_draw(line)
+#else
+#define FLASHSYNC_INIT()
+#define FLASHSYNC_START()
+#define FLASHSYNC_ARM()
+#define FLASHSYNC_EDGE()
+#define FLASHSYNC_ADAPTIVE(interval) false
+#define FLASHSYNC_MISSED(interval) false
+#define FLASHSYNC_DRAW(line)
+#endif
+
+#endif
@@ -0,0 +1,153 @@
+/**
+ * Camera Shutter Control Project, ISR instrumentation module
+ * By Electro707, 2023
+ *
+ * This keeps min/max/histogram counters of how long each ISR runs for and how late the Timer0 tick
+ * gets serviced, and draws them on a diagnostics page.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <string.h>
+#include "instrument.h"
+#include "oled.h"
+#include "scheduler.h"
+
+#ifdef INSTRUMENT
+
+#define HIST_BAR_WIDTH 14       // pixel width of each histogram bucket on the diagnostics page
+
+Instrument_s instrument;
+
+void instrument_init(void){
+    for(uint8_t i=0;i<INSTRUMENT_N_ISR;i++){
+        instrument.duration[i].min = 0xFFFF;
+    }
+    // Timer1 free running at CK/8, with the TOP at 0x3FF. The high bits go through TC1H
+    TCCR1A = 0;
+    TC1H = 0x03;
+    OCR1C = 0xFF;
+    TCCR1B = 0b0100;
+}
+
+static void hist_add(uint16_t *hist, uint8_t bucket){
+    if(bucket >= INSTRUMENT_HIST_SIZE){
+        bucket = INSTRUMENT_HIST_SIZE-1;
+    }
+    // saturate instead of wrapping
+    if(hist[bucket] != 0xFFFF){
+        hist[bucket]++;
+    }
+}
+
+/**
+ * Gets called at the end of an ISR with the Timer1 value from its entry
+ */
+void instrument_record(InstrumentISR_e isr, uint16_t start){
+    uint16_t duration = (instrument_timer1() - start) & 0x3FF;
+    InstrumentStats_s *s = &instrument.duration[isr];
+
+    if(duration < s->min){s->min = duration;}
+    if(duration > s->max){s->max = duration;}
+    hist_add(s->hist, duration >> INSTRUMENT_HIST_SHIFT);   // at most 31, the last bucket takes the rest
+}
+
+void instrument_record_latency(uint8_t latency){
+    hist_add(instrument.t0_latency, latency);
+}
+
+/**
+ * Clears the display while timing it against the TIMER0 tick, to measure the effective bus rate
+ *
+ * The rate counts 9 clocks per byte (8 data bits and the ACK), so it includes any gaps between bytes
+ */
+void instrument_bus_benchmark(void){
+    uint16_t start_ticks, end_ticks;
+    uint8_t start_tcnt, end_tcnt;
+    uint16_t start_bytes = oled_tx_bytes;
+    uint32_t elapsed_us;
+
+    cli();
+    start_ticks = tick_count;
+    start_tcnt = TCNT0L;
+    sei();
+    oled_clear_display();
+    cli();
+    end_ticks = tick_count;
+    end_tcnt = TCNT0L;
+    sei();
+
+    // each tick is 8ms, each TIMER0 count is 32us
+    elapsed_us = (uint32_t)(end_ticks - start_ticks) * 8000 + (int16_t)(end_tcnt - start_tcnt) * 32;
+    instrument.bus_khz = ((uint32_t)(oled_tx_bytes - start_bytes) * 9 * 1000) / elapsed_us;
+}
+
+/**
+ * Draws a histogram as a row of bars, with the height being the log4 of the count (rounded up), so the
+ * 16 bit counts fit in the 8 pixels of a line
+ */
+static void draw_hist(uint16_t *hist, uint8_t line){
+    uint16_t hist_copy[INSTRUMENT_HIST_SIZE];
+
+    cli();
+    memcpy(hist_copy, hist, sizeof(hist_copy));
+    sei();
+
+    for(uint8_t b=0;b<INSTRUMENT_HIST_SIZE;b++){
+        uint8_t height = 0;
+        uint8_t col;
+        for(uint16_t c=hist_copy[b];c;c>>=2){height++;}
+        col = (height == 0) ? 0x00 : (0xFF << (8-height));
+        // the last two columns are not drawn, leaving a gap between bars
+        oled_fill(col, HIST_BAR_WIDTH-2, line, b*HIST_BAR_WIDTH);
+    }
+}
+
+/**
+ * Converts a 16 bit number to a string of a given number of digits
+ */
+static void u16_to_ascii(uint16_t n, char *text, uint8_t digits){
+    while(digits--){
+        text[digits] = (n % 10) + 0x30;
+        n /= 10;
+    }
+}
+
+static void draw_duration(InstrumentISR_e isr, char *text, uint8_t line){
+    uint16_t min, max;
+
+    // text is in the format of "NAME   us xxxx:xxxx"
+    cli();
+    min = instrument.duration[isr].min;
+    max = instrument.duration[isr].max;
+    sei();
+    u16_to_ascii(min, &text[10], 4);
+    u16_to_ascii(max, &text[15], 4);
+    oled_send_text(text, line);
+    draw_hist(instrument.duration[isr].hist, line+1);
+}
+
+/**
+ * Draws the diagnostics page over the whole display
+ */
+void instrument_draw_page(void){
+    char text[22];
+
+    oled_send_text_P(PSTR("ISR DIAGNOSTICS"), 0);
+    strcpy_P(text, PSTR("TIMER0 us ----:----"));
+    draw_duration(INSTRUMENT_ISR_TIMER0, text, 1);
+    strcpy_P(text, PSTR("PCINT  us ----:----"));
+    draw_duration(INSTRUMENT_ISR_PCINT, text, 3);
+    oled_send_text_P(PSTR("T0 LATENCY x32us"), 5);
+    strcpy_P(text, PSTR("BYTES ----- KHZ -----"));
+    draw_hist(instrument.t0_latency, 6);
+    u16_to_ascii(instrument.screen_bytes, &text[6], 5);
+    u16_to_ascii(instrument.bus_khz, &text[16], 5);
+    oled_send_text(text, 7);
+}
+
+#endif
@@ -0,0 +1,75 @@
+/**
+ * Camera Shutter Control Project, ISR instrumentation module
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+#include <avr/io.h>
+
+/**
+ * ISR entry and exit are time-stamped against Timer1, which is otherwise unused and is left free running
+ * at CK/8 (1us per count at 8MHz) with a 10-bit TOP. Durations are therefore valid up to 1023us.
+ *
+ * Timer0 entry latency is taken from TCNT0L, which counts up from the compare match at CK/256 (32us per count).
+ */
+#define INSTRUMENT_HIST_SIZE 8
+#define INSTRUMENT_HIST_SHIFT 5     // each duration histogram bucket is 32us wide
+
+typedef enum{
+    INSTRUMENT_ISR_TIMER0 = 0,
+    INSTRUMENT_ISR_PCINT,
+    INSTRUMENT_N_ISR,
+}InstrumentISR_e;
+
+typedef struct{
+    uint16_t min;
+    uint16_t max;
+    uint16_t hist[INSTRUMENT_HIST_SIZE];
+}InstrumentStats_s;
+
+typedef struct{
+    InstrumentStats_s duration[INSTRUMENT_N_ISR];   // ISR entry to exit, in Timer1 counts
+    uint16_t t0_latency[INSTRUMENT_HIST_SIZE];      // Timer0 compare match to ISR entry, in Timer0 counts
+    uint16_t screen_bytes;                          // bytes sent to the display for the last full main screen draw
+    uint16_t bus_khz;                               // effective I2C bit rate measured while clearing the display
+}Instrument_s;
+
+#ifdef INSTRUMENT
+extern Instrument_s instrument;
+
+/**
+ * Reads the 10-bit Timer1 count. Reading the low byte latches the high bits into TC1H
+ */
+static inline uint16_t instrument_timer1(void){
+    uint8_t low = TCNT1;
+    return ((uint16_t)TC1H << 8) | low;
+}
+
+void instrument_init(void);
+void instrument_record(InstrumentISR_e isr, uint16_t start);
+void instrument_record_latency(uint8_t latency);
+void instrument_draw_page(void);
+void instrument_bus_benchmark(void);
+
+#define INSTRUMENT_INIT() instrument_init()
+#define INSTRUMENT_ISR_ENTRY() uint16_t _instrument_start = instrument_timer1()
+#define INSTRUMENT_ISR_EXIT(isr) instrument_record(isr, _instrument_start)
+#define INSTRUMENT_T0_LATENCY() instrument_record_latency(TCNT0L)
+#define INSTRUMENT_SCREEN_START() oled_tx_bytes = 0
+#define INSTRUMENT_SCREEN_END() instrument.screen_bytes = oled_tx_bytes
+#else
+#define INSTRUMENT_INIT()
+#define INSTRUMENT_ISR_ENTRY()
+#define INSTRUMENT_ISR_EXIT(isr)
+#define INSTRUMENT_T0_LATENCY()
+#define INSTRUMENT_SCREEN_START()
+#define INSTRUMENT_SCREEN_END()
+#endif
+
+#endif
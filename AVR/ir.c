@@ -0,0 +1,139 @@
+/**
+ * Camera Shutter Control Project, infrared remote output
+ * By Electro707, 2023
+ *
+ * This sends the IR shutter release codes of common cameras on the IR LED. The codes are tables of
+ * mark/space pairs in PROGMEM, computed at compile time from the protocol timings.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+#ifndef F_CPU
+#define F_CPU 8000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+#include "ir.h"
+#include "sysclk.h"
+
+#ifdef IR_REMOTE
+
+#ifdef INSTRUMENT
+#error "IR_REMOTE and INSTRUMENT both use Timer1"
+#endif
+
+// Nikon ML-L3, 38.4kHz. The code is sent twice, 63ms apart
+#define NIKON_KHZ 38
+static const IRPulse_s nikon_pulses[] PROGMEM = {
+    {IR_MARK(2000, NIKON_KHZ), IR_SPACE(27830)},
+    {IR_MARK(390, NIKON_KHZ), IR_SPACE(1580)},
+    {IR_MARK(410, NIKON_KHZ), IR_SPACE(3580)},
+    {IR_MARK(400, NIKON_KHZ), IR_SPACE(31600)},
+    {0, IR_SPACE(31600)},
+    {IR_MARK(2000, NIKON_KHZ), IR_SPACE(27830)},
+    {IR_MARK(390, NIKON_KHZ), IR_SPACE(1580)},
+    {IR_MARK(410, NIKON_KHZ), IR_SPACE(3580)},
+    {IR_MARK(400, NIKON_KHZ), 1},
+};
+
+// Canon RC-1/RC-6, 32.6kHz. Two 16 period bursts, 7.3ms apart for an instant release
+#define CANON_KHZ 33
+static const IRPulse_s canon_pulses[] PROGMEM = {
+    {16, IR_SPACE(7330)},
+    {16, 1},
+};
+
+typedef struct{
+    const IRPulse_s *pulses;
+    uint8_t n_pulses;
+    uint8_t half_period;        // half of a carrier period, in CPU cycles
+}IRCode_s;
+
+static const IRCode_s ir_codes[IR_N_PROTOCOLS] PROGMEM = {
+    [IR_PROTOCOL_NIKON] = {nikon_pulses, sizeof(nikon_pulses)/sizeof(IRPulse_s), IR_HALF_PERIOD(38.4)},
+    [IR_PROTOCOL_CANON] = {canon_pulses, sizeof(canon_pulses)/sizeof(IRPulse_s), IR_HALF_PERIOD(32.6)},
+};
+
+int32_t ir_protocol = IR_PROTOCOL_OFF;      // selected protocol, edited from the menu
+
+static const IRPulse_s *pulse;              // next pulse to send
+static volatile uint8_t pulses_left = 0;
+static uint8_t half_period;
+
+/**
+ * Toggles the LED for the given number of carrier periods. Each loop iteration is one half period,
+ * with the loop overhead taken out of the delay
+ */
+#define CARRIER_LOOP_OVERHEAD 6
+static void send_mark(uint16_t periods){
+    uint16_t toggles = periods << 1;
+    // the delay has to be a compile time constant, so pick it from the supported carriers
+    if(half_period == IR_HALF_PERIOD(32.6)){
+        while(toggles--){
+            IR_PIN_TOGGLE = IR_PIN;
+            __builtin_avr_delay_cycles(IR_HALF_PERIOD(32.6) - CARRIER_LOOP_OVERHEAD);
+        }
+    } else {
+        while(toggles--){
+            IR_PIN_TOGGLE = IR_PIN;
+            __builtin_avr_delay_cycles(IR_HALF_PERIOD(38.4) - CARRIER_LOOP_OVERHEAD);
+        }
+    }
+    IR_PORT &= ~IR_PIN;
+}
+
+/**
+ * Starts sending the selected protocol's code. Can be called from an ISR
+ */
+void ir_fire(void){
+    if(ir_protocol <= IR_PROTOCOL_OFF || ir_protocol >= IR_N_PROTOCOLS || pulses_left){
+        return;
+    }
+    sysclk_full();      // the carrier is timed in full speed cycles
+    pulse = pgm_read_ptr(&ir_codes[ir_protocol].pulses);
+    half_period = pgm_read_byte(&ir_codes[ir_protocol].half_period);
+    pulses_left = pgm_read_byte(&ir_codes[ir_protocol].n_pulses);
+
+    // start the first pulse on the next Timer1 count
+    TCCR1A = 0;
+    TCCR1B = 0;
+    TC1H = 0;
+    TCNT1 = 0;
+    OCR1C = 1;
+    TIFR = (1 << TOV1);
+    TIMSK |= (1 << TOIE1);
+    TCCR1B = 0b1001;        // CK/256
+}
+
+bool ir_busy(void){
+    return pulses_left != 0;
+}
+
+/**
+ * Timer1 reaching TOP is the end of a space, so send the next mark and time the space after it
+ */
+ISR(TIMER1_OVF_vect){
+    uint16_t space;
+
+    if(pulses_left == 0){
+        TCCR1B = 0;
+        TIMSK &= ~(1 << TOIE1);
+        return;
+    }
+    send_mark(pgm_read_word(&pulse->mark));
+    space = pgm_read_word(&pulse->space);
+    pulse++;
+    pulses_left--;
+
+    // TOP is 10 bits, with the high bits written to TC1H first
+    TC1H = 0;
+    TCNT1 = 0;
+    TC1H = space >> 8;
+    OCR1C = space;
+    TIFR = (1 << TOV1);
+}
+
+#endif
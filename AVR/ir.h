@@ -0,0 +1,59 @@
+/**
+ * Camera Shutter Control Project, infrared remote output
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef IR_H
+#define IR_H
+
+#include <avr/io.h>
+#include <stdbool.h>
+
+#define IR_PORT PORTA
+#define IR_PIN_TOGGLE PINA
+#define IR_PIN (1 << 5)
+
+/**
+ * The IR LED is on PA5, which has no timer output, so the carrier is generated by a cycle-counted
+ * toggle loop with interrupts disabled for the length of each mark. The spaces between marks are
+ * timed with Timer1 at CK/256 (32us per count), with interrupts enabled. Marks must stay well under
+ * the 8ms tick so that no TIMER0 tick gets lost.
+ *
+ * A pulse table entry is the number of carrier periods of the mark (0 for none), then the space
+ * after it in Timer1 counts (1 to 1023, so up to ~32ms). IR_MARK and IR_SPACE convert to these at
+ * compile time.
+ */
+#define IR_TIMER1_PRESCALER 256
+#define IR_HALF_PERIOD(khz) ((uint8_t)((F_CPU / 2000.0) / (khz) + 0.5))
+#define IR_MARK(us, khz) ((uint16_t)(((uint32_t)(us) * (khz) + 500) / 1000))
+#define IR_SPACE(us) ((uint16_t)(((uint32_t)(us) * (F_CPU / 1000000UL) + IR_TIMER1_PRESCALER / 2) / IR_TIMER1_PRESCALER))
+
+typedef enum{
+    IR_PROTOCOL_OFF = 0,
+    IR_PROTOCOL_NIKON,
+    IR_PROTOCOL_CANON,
+    IR_N_PROTOCOLS,
+}IRProtocol_e;
+
+typedef struct{
+    uint16_t mark;      // in carrier periods
+    uint16_t space;     // in Timer1 counts
+}IRPulse_s;
+
+#ifdef IR_REMOTE
+extern int32_t ir_protocol;
+
+void ir_fire(void);
+bool ir_busy(void);
+
+#define TRIGGER_IR() ir_fire()
+#else
+#define TRIGGER_IR()
+#define ir_busy() false
+#endif
+
+#endif
@@ -0,0 +1,20 @@
+/**
+ * Camera Shutter Control Project, pre-rendered screen layouts
+ * By Electro707, 2023
+ *
+ * The layouts are generated at build time by layout_gen.py, in the format oled_send_layout() takes
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+extern const uint8_t main_layout[] PROGMEM;     // labels of the first channel's settings screen
+
+#endif
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""
+Camera Shutter Control Project, layout generator
+
+Pre-renders the static part of the main settings screen, which is the labels of the settings fields,
+into a run-length encoded screen image, so it can be sent to the display in one pass instead of
+drawing each label (and clearing the screen) on its own. The labels and their positions are read from
+the menu_fields table in fields.c, and the glyphs from the font in letters.c, so the image always
+matches what menu_draw_labels() would draw. Fields inside an #ifdef get their own image variant.
+
+    ./layout_gen.py fields.c letters.c > build/layout.c
+
+The image is a list of runs, each starting with a count byte. With bit 7 set, the next byte is
+repeated (count & 0x7F) + 1 times, otherwise the next count + 1 bytes are copied as they are. The runs
+add up to the 128x64 screen, in the display's horizontal addressing order.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+"""
+import argparse
+import re
+
+WIDTH = 128
+LINES = 8
+GLYPH_WIDTH = 5
+MAX_RUN = 128
+
+
+def read_font(name):
+    with open(name) as f:
+        text = f.read()
+    body = text[text.index("{", text.index("font[]")):text.index("};")]
+    # drop the comments, some of them are characters that look like numbers
+    body = re.sub(r"//.*", "", body)
+    return [int(b, 16) for b in re.findall(r"0x[0-9A-Fa-f]{2}", body)]
+
+
+def read_fields(name):
+    """Returns the (label text, line, column, ifdef) of every field of menu_fields"""
+    with open(name) as f:
+        text = f.read()
+    labels = dict(re.findall(r'const char (label_\w+)\[\] PROGMEM = "(.*)";', text))
+    start = text.index("const MenuField_s menu_fields[] PROGMEM = {")
+    table = text[start:text.index("};", start)]
+
+    fields = []
+    ifdef = None
+    for line in table.splitlines():
+        line = line.strip()
+        if line.startswith("#ifdef"):
+            ifdef = line.split()[1]
+        elif line.startswith("#endif"):
+            ifdef = None
+        else:
+            m = re.match(r"\{\s*(label_\w+)\s*,\s*&[^,]+,[^,]+,[^,]+,\s*(\d+)\s*,\s*(\d+)", line)
+            if m:
+                fields.append((labels[m.group(1)], int(m.group(2)), int(m.group(3)), ifdef))
+    return fields
+
+
+def render(fields, font):
+    """Draws the labels the same way oled_send_chars() does, on the line above their field"""
+    screen = bytearray(WIDTH * LINES)
+    for label, line, column, _ in fields:
+        pos = (line - 1) * WIDTH + column
+        for c in label:
+            glyph = (ord(c) - 0x20) * GLYPH_WIDTH
+            for col in font[glyph:glyph + GLYPH_WIDTH] + [0x00]:
+                if column < WIDTH:
+                    screen[pos] = col
+                pos += 1
+                column += 1
+    return screen
+
+
+def compress(data):
+    out = bytearray()
+    literal = bytearray()
+    i = 0
+
+    def flush():
+        if literal:
+            out.append(len(literal) - 1)
+            out.extend(literal)
+            literal.clear()
+
+    while i < len(data):
+        run = 1
+        while i + run < len(data) and run < MAX_RUN and data[i + run] == data[i]:
+            run += 1
+        # runs of 2 cost as much either way, so they stay in the literal
+        if run >= 3:
+            flush()
+            out.append(0x80 | (run - 1))
+            out.append(data[i])
+            i += run
+        else:
+            literal.append(data[i])
+            i += 1
+            if len(literal) == MAX_RUN:
+                flush()
+    flush()
+    return out
+
+
+def c_array(name, data):
+    lines = ["const uint8_t {}[] PROGMEM = {{".format(name)]
+    for i in range(0, len(data), 16):
+        lines.append("    " + " ".join("0x{:02X},".format(b) for b in data[i:i + 16]))
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("fields", help="fields.c, with the menu_fields table")
+    parser.add_argument("font", help="letters.c, with the font")
+    args = parser.parse_args()
+
+    font = read_font(args.font)
+    fields = read_fields(args.fields)
+    base = [f for f in fields if f[3] is None]
+
+    options = sorted(set(f[3] for f in fields if f[3] is not None))
+    if len(options) > 1:
+        parser.error("only one #ifdef in menu_fields is supported, found " + ", ".join(options))
+
+    print("// generated by layout_gen.py from {} and {}, don't edit".format(args.fields, args.font))
+    print("#include \"layout.h\"\n")
+    if options:
+        print("#ifdef {}".format(options[0]))
+        print(c_array("main_layout", compress(render(fields, font))))
+        print("#else")
+        print(c_array("main_layout", compress(render(base, font))))
+        print("#endif")
+    else:
+        print(c_array("main_layout", compress(render(base, font))))
+
+if __name__ == "__main__":
+    main()
@@ -9,7 +9,6 @@
  * License, or (at your option) any later version.
  */
 #define F_CPU 8000000       // CPU clock cycles
-#define N_DIGITS    5
 
 #include <stdbool.h>
 #include <avr/io.h>
@@ -18,123 +17,117 @@
 #include <stdlib.h>
 #include "USI_TWI_Master.h"
 #include "oled.h"
+#include "telemetry.h"
+#include "instrument.h"
+#include "board.h"
+#include "trigger.h"
+#include "scheduler.h"
+#include "buttons.h"
+#include "sysclk.h"
+#include "menu.h"
+#include "progress.h"
+#include "recovery.h"
+#include "deepsleep.h"
+#include "trim.h"
+#include "flashsync.h"
+#include "ir.h"
+#include "fields.h"
+#include "layout.h"
+#include "encoder.h"
+#include "simtrace.h"
 
 
-/* LED Related Macros */
-#define LED_PORT PORTB
-#define LED_RED_PIN (1 << 1)
-#define LED_GREEN_PIN (1 << 3)
-#define LED_BLUE_PIN (1 << 5)
-#define TURN_ON_RED_LED (LED_PORT &= ~LED_RED_PIN)
-#define TURN_ON_GREEN_LED (LED_PORT &= ~LED_GREEN_PIN)
-#define TURN_ON_BLUE_LED (LED_PORT &= ~LED_BLUE_PIN)
-#define TURN_OFF_RED_LED (LED_PORT |= LED_RED_PIN)
-#define TURN_OFF_GREEN_LED (LED_PORT |= LED_GREEN_PIN)
-#define TURN_OFF_BLUE_LED (LED_PORT |= LED_BLUE_PIN)
-#define TURN_OFF_ALL_LED TURN_OFF_RED_LED; TURN_OFF_GREEN_LED; TURN_OFF_BLUE_LED
-#define TURN_ON_CYAN TURN_ON_GREEN_LED; TURN_ON_BLUE_LED
-/* Rotary Encoder and Button Read Macros */
-#define READ_ROTARY_ENCODER_BIT ((PINA >> 6) & 0b11)
-#define READ_ROTARY_ENCODER_BUTTON ((PINB >> 4) & 0b1)
-#define READ_TRIGGER_BUTTON ((PINA >> 2) & 0b1)
-#define READ_MODE_BUTTON ((PINA >> 3) & 0b1)
-/* Trigger Related Macros */
-#define TRIGGER_ON PORTA |= (1 << 1); PORTA |= (1 << 0)
-#define TRIGGER_OFF PORTA &= ~(1 << 1); PORTA &= ~(1 << 0)
-
 #define RESET_TIMER TCNT0H = 0; TCNT0L = 0
 
-typedef enum{
-    ROTARY_ENCODER_ROT_NOTHING = 0,
-    ROTARY_ENCODER_ROT_CW = 1,
-    ROTARY_ENCODER_ROT_CCW = 2,
-}RotaryEncoderRotation_e;
-
-typedef enum{
-    TRIGGER_MODE_STANDBY = 0,               // standby, doing nothing
-    TRIGGER_MODE_ARM,                       // arming, i.e waiting for trigger
-    TRIGGER_MODE_TRIGGERED,                 // triggered the camera
-    TRIGGER_MODE_WAITING_FOR_NEXT_PIC,      // waiting for the next picture in a multi picture arm
-    TRIGGER_MODE_END,                       // end of trigger
-}TriggerMode_e;
-
-typedef enum{
-    VARIABLE_CHANGE_TRT = 0,
-    VARIABLE_CHANGE_TT,
-    VARIABLE_CHANGE_NPIC,
-    VARIABLE_CHANGE_INVERV,
-}ChangeVariable_e;
-
 typedef struct{
     RotaryEncoderRotation_e dir;
-    bool bt_press;   // true if we pressed on the rotary encoder
 }RotaryEncoderStruct_s;
 
-/**
- * All trigger settings
- */
-typedef struct{
-    int16_t tt;         // Time to Trigger
-    int16_t trt;        // Trigger Duration
-    int16_t n_pic;      // number of pictures for timelapse mode
-    int16_t tmlps_interv;   // The interval in seconds between different timelapse
-}ShutterTriggerVars_s;
-
 /**
  * Any system/run-time config
  */
 typedef struct{
     TriggerMode_e mode;                 // the current trigger state machine mode
-    ChangeVariable_e selected_to_change;     // index to variable we selected to be changed
-    uint8_t selected_digit;         // index to digit to be changed
-    int16_t *var_to_change;        // pointer to variable to change
 }SystemConfig_s;
 
-const int16_t tens_radix[5] = {1, 10, 100, 1000, 10000};
-
-uint8_t blinking_led_var = 0;       // Variable used for blinking an LED during pre-trigger time
 uint8_t timer_counter = 0;          // Counter used to make TIMER0 count once a second
+uint16_t tick_count = 0;            // Free running count of TIMER0 ticks, used for telemetry time-stamps
 
 int currBattBar = -1;
 uint8_t isCharging = false;
 
-uint8_t flagUpdateTrigTime = false;
+uint8_t showDiagPage = false;       // true if the ISR diagnostics page is being shown instead of the settings
+uint8_t showProgressPage = false;   // true if the sequence progress view is being shown instead of the settings
+uint8_t showTrimPage = false;       // true if the clock trim page is being shown instead of the settings
+uint8_t settingsChannel = 0;        // channel whose settings are shown
 
-ShutterTriggerVars_s shutter_trigger = {0};
-ShutterTriggerVars_s old_shutter_trigger = {0};
+TriggerChannel_s channels[TRIGGER_N_CHANNELS] RECOVERY_NOINIT;    // survives a watchdog reset, see recovery.h
 RotaryEncoderStruct_s encoder_vars;
 SystemConfig_s sys;
 
-int text_to_ascii(uint16_t n, char *text);
-void update_sutter_trigger_time(void);
-void increment_change_var(void);
+void draw_main_screen(void);
+void show_channel_settings(uint8_t channel);
+void draw_trim_page(void);
 void start_arming(void);
+void sleep_until_window(void);
+int32_t scheduled_delay(void);
 
 void updateBatteryLevel(void);
 void update_batt_indicator(void);
 
+void task_input(void);
+void task_display(void);
+void task_sequence(void);
+void task_recover(void);
+#ifdef INSTRUMENT
+void task_diag(void);
+#endif
+
+/**
+ * All tasks, in priority order. Periods are in 8ms ticks. The battery and display checks run often, so
+ * they don't switch the clock back to full speed between pictures
+ */
+const Task_s tasks[] PROGMEM = {
+    {task_input, EVENT_INPUT, 0, 0},
+    {task_display, EVENT_DISPLAY, 0, 0},
+    {task_sequence, EVENT_SEQUENCE, 0, 0},
+    {updateBatteryLevel, EVENT_BATTERY, 13, SCHED_ANY_CLOCK},
+    {task_recover, EVENT_RECOVER, 125, SCHED_ANY_CLOCK},
+#ifdef INSTRUMENT
+    {task_diag, EVENT_DIAG, 125, 0},
+#endif
+};
+
 int main(void){
-    uint8_t mode_bt_press = 0;
-    int16_t change_by;
-    // Clear variables
-    shutter_trigger.tt = 0;
-    shutter_trigger.trt = 10;
+    RecoveryState_s resume;
+    bool resuming;
+
+    // Clear variables. The channels are left alone if a sequence carries on after a watchdog reset
+    resuming = recovery_restore(channels, &resume);
+    if(!resuming){
+        memset(channels, 0, sizeof(channels));
+        channels[0].cur.trt = 10;
+    }
     sys.mode = TRIGGER_MODE_STANDBY;
-    sys.selected_to_change = VARIABLE_CHANGE_TRT;
-    sys.var_to_change = &shutter_trigger.trt;
-    encoder_vars.bt_press = 0;
+    menu_init(menu_fields, sizeof(menu_fields)/sizeof(MenuField_s));
 
     // Setup GPIO
     DDRA = 0b00100011;
     DDRB = 0b00101111;
 
     PORTA |= (0b11 << 6);
-
-    // Setup Timer 0 as the main ticker counter
-    // 8Mhz / 256 / 250 = 125 Hz
-    OCR0A = 250;
+    TELEMETRY_INIT();
+    INSTRUMENT_INIT();
+    // both pin change masks start out with every pin enabled. PCMSK1 is cleared before the flash-sync
+    // adds its pin, so the encoder button, blue LED, charge sense and reset pins don't fire the ISR
+    PCMSK1 = 0;
+    FLASHSYNC_INIT();
+
+    // Setup Timer 0 as the main ticker counter, with the saved clock trim
+    OCR0A = TRIM_TIMER0_TOP;
+    trim_load();
     TCCR0A = 1;
-    TCCR0B = 0b100;
+    TCCR0B = SYSCLK_TIMER0_FULL;
     TIMSK |= 1 << OCIE0A;
 
     // Clear Rotary Encoder LEDs
@@ -146,7 +139,7 @@ int main(void){
     GIMSK |= (1 << PCIE1);
 //     PCMSK0 |= (1 << PCINT2) | (1 << PCINT3) | (1 << PCINT6) | (1 << PCINT7);
 //     PCMSK1 |= (1 << PCINT12);
-    PCMSK0 |= (1 << PCINT6) | (1 << PCINT7);
+    PCMSK0 = (1 << PCINT6) | (1 << PCINT7);     // only the encoder pins
 
     // enable the battery ADC input, ADC3
     ADMUX = (1 << REFS1) | (0b00011);      // select 2.56v reference, set mux to single ended PA4
@@ -160,158 +153,297 @@ int main(void){
     oled_init();
     // oled_send_text("CAMERA SHUTTER", 0);
     // oled_send_text("CONTROLLER REV 0.1", 1);
-    update_sutter_trigger_time();
-    oled_send_text("Shutter Speed:", 0);
-    oled_send_text("T- Trigger:", 2);
-    oled_send_text("Timelapse:", 4);
 
-    oled_send_text_offset("# Pics:", 5, 0);
-    oled_send_text_offset("Interv:", 5, 64);
+    // carry on with a sequence that got interrupted by a watchdog reset. The shutter lines got released
+    // by the reset, so they are pressed again if a picture was still being taken
+    if(resuming){
+        sys.mode = resume.mode;
+        progress_resume(channels, &resume.progress);
+        for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+            if(channels[i].mode == TRIGGER_MODE_TRIGGERED){
+                TRIGGER_ON(channels[i].pins);
+            }
+        }
+    }
+    // otherwise the progress view gets drawn by task_sequence on start-up. The display only gets turned
+    // on once it has something on it
+    if(sys.mode == TRIGGER_MODE_STANDBY){
+        draw_main_screen();
+    } else {
+        oled_clear_display();
+    }
+    oled_display_on(true);
     
+    sched_init(tasks, sizeof(tasks)/sizeof(Task_s));
+    recovery_init();
+
     // Enable interrupts
     sei();
+
+#ifdef SIMAVR
+    // the simulator has nothing to press the trigger button with, so the trace build arms right away
+    simtrace_settings(channels);
+    start_arming();
+    simtrace_armed();
+#endif
     
     while(1){
-        _delay_ms(10);
-        updateBatteryLevel();
-        // only update if we are in standby
+        int32_t start_delay;
+
+#ifdef SIMAVR
+        // and the trace ends along with the sequence
         if(sys.mode == TRIGGER_MODE_STANDBY){
-            // if we turn the rotary encoder
-            if(encoder_vars.dir != ROTARY_ENCODER_ROT_NOTHING){
-                change_by = tens_radix[sys.selected_digit];
-                if(encoder_vars.dir == ROTARY_ENCODER_ROT_CW){
-                    TURN_ON_RED_LED;
-                    TURN_OFF_GREEN_LED;
-                    *sys.var_to_change += change_by;
-                }
-                else if(encoder_vars.dir ==ROTARY_ENCODER_ROT_CCW){
-                    TURN_ON_GREEN_LED;
-                    TURN_OFF_RED_LED;
-                    *sys.var_to_change -= change_by;
-                    // special case for trt were we are capping it at 1
-                    if(shutter_trigger.trt < 1)
-                        shutter_trigger.trt = 1;
-                    // cap any values at 0
-                    if(*sys.var_to_change < 0)
-                        *sys.var_to_change = 0;
-                }
-                update_sutter_trigger_time();
-                // Clear this variable after we are done with it
-                encoder_vars.dir = ROTARY_ENCODER_ROT_NOTHING;
-            }
-            // if we press the trigger button, change MODE and start the arming
-            if(READ_TRIGGER_BUTTON == 0){
-                start_arming();
-            }
-            // if we press the mode button, switch modes
-            if(READ_MODE_BUTTON == 0 && mode_bt_press == 0){
-                mode_bt_press = 1;
-                increment_change_var();
-            }
-            else if(READ_MODE_BUTTON == 1 && mode_bt_press){
-                mode_bt_press = 0;
-            }
-            // if we press the rotary encoder button, switch what value we are changing
-            if(READ_ROTARY_ENCODER_BUTTON == 1 && encoder_vars.bt_press == 0){
-                encoder_vars.bt_press = 1;
-                sys.selected_digit += 1;
-                if(sys.selected_digit >= N_DIGITS){
-                    sys.selected_digit = 0;
-                }
-                update_sutter_trigger_time();
-            }
-            // down-press on rotary encoder button
-            else if(READ_ROTARY_ENCODER_BUTTON == 0 && encoder_vars.bt_press == 1){
-                encoder_vars.bt_press = 0;
-            }
+            simtrace_end();
+        }
+#endif
+        RECOVERY_KICK();
+        sched_run();
+        TELEMETRY_FLUSH();
+        // the wait between pictures can be long, so run slower to save power while nothing is happening.
+        // A picture can start sending IR from the timer ISR, so this is checked with interrupts off
+        cli();
+        if((sys.mode == TRIGGER_MODE_WAITING_FOR_NEXT_PIC || sys.mode == TRIGGER_MODE_SCHEDULED) && !ir_busy()){
+            sysclk_slow();
         }
-        if(flagUpdateTrigTime){
-            flagUpdateTrigTime = false;
-            update_sutter_trigger_time();
+        sei();
+        // and power down completely while waiting for the window to open
+        TRIGGER_READ(start_delay = scheduled_delay());
+        if(sys.mode == TRIGGER_MODE_SCHEDULED && start_delay > DEEPSLEEP_RESYNC_SECONDS && !ir_busy()){
+            sleep_until_window();
+            continue;
         }
+        sched_sleep();
     }
 }
 
-void start_arming(void){
-    // check that interval time, if npic != 0, is greater than trt
-    if(shutter_trigger.n_pic != 0){
-        if(shutter_trigger.tmlps_interv < (shutter_trigger.trt+shutter_trigger.tt)){
-            return;
+/**
+ * Handles the buttons and rotary encoder. Runs when a button event happens or the encoder turns
+ */
+void task_input(void){
+#ifdef INSTRUMENT
+    // hold down the rotary encoder button and press the mode button to toggle the diagnostics page
+    if(sys.mode == TRIGGER_MODE_STANDBY && !showTrimPage && (buttons_state() & BUTTON_ENCODER) && buttons_get_press(BUTTON_MODE)){
+        showDiagPage = !showDiagPage;
+        if(showDiagPage){
+            instrument_bus_benchmark();
+            sched_set_event(EVENT_DIAG);
+        } else {
+            draw_main_screen();
+        }
+    }
+    if(showDiagPage){
+        buttons_get_press(BUTTON_MODE | BUTTON_TRIGGER | BUTTON_ENCODER);
+        return;
+    }
+#endif
+    // hold down the rotary encoder button and press the trigger button to open the clock trim page, the
+    // trim gets saved when doing the same to go back
+    if(sys.mode == TRIGGER_MODE_STANDBY && (buttons_state() & BUTTON_ENCODER) && buttons_get_press(BUTTON_TRIGGER)){
+        showTrimPage = !showTrimPage;
+        if(showTrimPage){
+            oled_clear_display();
+            menu_init(trim_fields, sizeof(trim_fields)/sizeof(MenuField_s));
+            draw_trim_page();
+        } else {
+            trim_save();
+            show_channel_settings(settingsChannel);
         }
     }
+    if(showTrimPage){
+        if(encoder_vars.dir != ROTARY_ENCODER_ROT_NOTHING){
+            menu_change(encoder_vars.dir == ROTARY_ENCODER_ROT_CW ? 1 : -1);
+            trim_apply();
+            sched_set_event(EVENT_DISPLAY);
+            encoder_vars.dir = ROTARY_ENCODER_ROT_NOTHING;
+        }
+        // the trigger button takes the reference pulses here
+        if(buttons_get_press(BUTTON_TRIGGER)){
+            trim_reference_pulse();
+            trim_draw_page();
+            menu_invalidate(MENU_ALL_FIELDS);
+            sched_set_event(EVENT_DISPLAY);
+        }
+        if(buttons_get_press(BUTTON_ENCODER)){
+            menu_next_digit();
+            sched_set_event(EVENT_DISPLAY);
+        }
+        buttons_get_press(BUTTON_MODE);
+        buttons_get_release(BUTTON_MODE | BUTTON_TRIGGER | BUTTON_ENCODER);
+        buttons_get_long(BUTTON_MODE | BUTTON_TRIGGER | BUTTON_ENCODER);
+        return;
+    }
+    // only update if we are in standby
+    if(sys.mode == TRIGGER_MODE_STANDBY){
+        // if we turn the rotary encoder
+        if(encoder_vars.dir != ROTARY_ENCODER_ROT_NOTHING){
+            if(encoder_vars.dir == ROTARY_ENCODER_ROT_CW){
+                TURN_ON_RED_LED;
+                TURN_OFF_GREEN_LED;
+                menu_change(1);
+            }
+            else if(encoder_vars.dir ==ROTARY_ENCODER_ROT_CCW){
+                TURN_ON_GREEN_LED;
+                TURN_OFF_RED_LED;
+                menu_change(-1);
+            }
+            sched_set_event(EVENT_DISPLAY);
+            // Clear this variable after we are done with it
+            encoder_vars.dir = ROTARY_ENCODER_ROT_NOTHING;
+        }
+        // if we press the trigger button, change MODE and start the arming
+        if(buttons_get_press(BUTTON_TRIGGER)){
+            start_arming();
+        }
+        // if we press the mode button, switch modes
+        if(buttons_get_press(BUTTON_MODE)){
+            menu_next_field();
+            sched_set_event(EVENT_DISPLAY);
+        }
+        // and holding it down switches between the settings of the two channels
+        if(buttons_get_long(BUTTON_MODE)){
+            show_channel_settings(!settingsChannel);
+        }
+        // if we press the rotary encoder button, switch what value we are changing
+        if(buttons_get_press(BUTTON_ENCODER)){
+            menu_next_digit();
+            sched_set_event(EVENT_DISPLAY);
+        }
+    } else {
+        // drop any presses during a sequence, so they don't act once it ends
+        buttons_get_press(BUTTON_MODE | BUTTON_TRIGGER | BUTTON_ENCODER);
+    }
+    // releases and the other long presses are not used yet
+    buttons_get_release(BUTTON_MODE | BUTTON_TRIGGER | BUTTON_ENCODER);
+    buttons_get_long(BUTTON_MODE | BUTTON_TRIGGER | BUTTON_ENCODER);
+}
 
-    memcpy(&old_shutter_trigger, &shutter_trigger, sizeof(shutter_trigger));
-    blinking_led_var = 0;
-    timer_counter = 0;
-    RESET_TIMER;
-    TURN_OFF_ALL_LED;
-    // if(shutter_trigger.tt == 0){
-        // TRIGGER_ON;
-        // sys.mode = TRIGGER_MODE_TRIGGERED;
-    // } else {
-        sys.mode = TRIGGER_MODE_ARM;
-    // }
+/**
+ * Redraws the settings that got edited
+ */
+void task_display(void){
+#ifdef INSTRUMENT
+    if(showDiagPage){
+        return;
+    }
+#endif
+    // the progress view is shown instead during a sequence
+    if(sys.mode == TRIGGER_MODE_STANDBY){
+        menu_draw();
+    }
 }
 
 /**
- * Gets called when we want to increment what variable we are changing
+ * Updates the progress view after the trigger sequence stepped, and goes back to the settings screen
+ * once it ends
  */
-void increment_change_var(void){
-    switch (sys.selected_to_change){
-    case VARIABLE_CHANGE_TRT:
-        sys.selected_to_change = VARIABLE_CHANGE_TT;
-        sys.var_to_change = &shutter_trigger.tt;
-        break;
-    case VARIABLE_CHANGE_TT:
-        sys.selected_to_change = VARIABLE_CHANGE_NPIC;
-        sys.var_to_change = &shutter_trigger.n_pic;
-        break;
-    case VARIABLE_CHANGE_NPIC:
-        sys.selected_to_change = VARIABLE_CHANGE_INVERV;
-        sys.var_to_change = &shutter_trigger.tmlps_interv;
-        break;
-    case VARIABLE_CHANGE_INVERV:
-        sys.selected_to_change = VARIABLE_CHANGE_TRT;
-        sys.var_to_change = &shutter_trigger.trt;
-        break;
-    }
-    update_sutter_trigger_time();
+void task_sequence(void){
+    if(sys.mode == TRIGGER_MODE_STANDBY){
+        if(showProgressPage){
+            showProgressPage = false;
+            draw_main_screen();
+        }
+    } else {
+        showProgressPage = true;
+        progress_draw();
+        FLASHSYNC_DRAW(1);
+    }
 }
 
 /**
- * Updates the display with the current trigger times
+ * Checks once a second if talking to the display failed, in which case the bus and display get reset
+ * and whatever was shown gets drawn again. The trigger sequence is run from the timer ISR, so it keeps
+ * going while the display is out
  */
-void update_sutter_trigger_time(void){
-    char text[7];
-    int8_t underscore_digit;
+void task_recover(void){
+    if(!oled_faulted()){
+        return;
+    }
+    // redrawing the whole screen at the slow clock would take longer than the watchdog timeout
+    sysclk_full();
+    if(!oled_recover()){
+        return;
+    }
+#ifdef INSTRUMENT
+    if(showDiagPage){
+        sched_set_event(EVENT_DIAG);
+        return;
+    }
+#endif
+    if(showProgressPage){
+        progress_invalidate();
+        sched_set_event(EVENT_SEQUENCE);
+    } else if(showTrimPage){
+        draw_trim_page();
+    } else {
+        draw_main_screen();
+    }
+}
 
-    underscore_digit = 0xFF;
-    text_to_ascii(shutter_trigger.trt, text);
-    if(sys.selected_to_change == VARIABLE_CHANGE_TRT){
-        underscore_digit = N_DIGITS-sys.selected_digit-1;
+#ifdef INSTRUMENT
+void task_diag(void){
+    if(showDiagPage){
+        instrument_draw_page();
     }
-    oled_send_text_underscore(text, 1, underscore_digit);
+}
+#endif
 
-    underscore_digit = 0xFF;
-    text_to_ascii(shutter_trigger.tt, text);
-    if(sys.selected_to_change == VARIABLE_CHANGE_TT){
-        underscore_digit = N_DIGITS-sys.selected_digit-1;
+void start_arming(void){
+    // the timer ISR leaves the sequence state alone in standby, so it is all safe to set up here as long
+    // as the mode is changed last
+    if(trigger_arm(channels) == TRIGGER_MODE_STANDBY){
+        return;
     }
-    oled_send_text_underscore(text, 3, underscore_digit);
+    progress_start(channels);
+    timer_counter = 0;
+    RESET_TIMER;
+    TURN_OFF_ALL_LED;
+    sys.mode = channels[0].mode;
+    TELEMETRY_SEND(TELEMETRY_STATE, sys.mode, TELEMETRY_U16(tick_count));
+    sched_set_event(EVENT_SEQUENCE);
+}
 
-    underscore_digit = 0xFF;
-    text_to_ascii(shutter_trigger.n_pic, text);
-    if(sys.selected_to_change == VARIABLE_CHANGE_NPIC){
-        underscore_digit = N_DIGITS-sys.selected_digit-1;
+/**
+ * Draws the whole main settings screen over whatever was on the display
+ *
+ * The labels of the first channel come from a pre-rendered image (see layout_gen.py), which also blanks
+ * out the rest of the screen in the same pass
+ */
+void draw_main_screen(void){
+    INSTRUMENT_SCREEN_START();
+    if(settingsChannel == 0){
+        oled_send_layout(main_layout);
+    } else {
+        oled_clear_display();
+        menu_draw_labels();
+        oled_send_text_P(PSTR("Channel 2"), 7);
     }
-    oled_send_text_underscore(text, 6, underscore_digit);
+    menu_invalidate(MENU_ALL_FIELDS);
+    menu_draw();
+    update_batt_indicator();
+    INSTRUMENT_SCREEN_END();
+}
 
-    underscore_digit = 0xFF;
-    text_to_ascii(shutter_trigger.tmlps_interv, text);
-    if(sys.selected_to_change == VARIABLE_CHANGE_INVERV){
-        underscore_digit = N_DIGITS-sys.selected_digit-1;
+/**
+ * Switches the settings screen to the settings of a channel
+ */
+void show_channel_settings(uint8_t channel){
+    settingsChannel = channel;
+    if(channel == 0){
+        menu_init(menu_fields, sizeof(menu_fields)/sizeof(MenuField_s));
+    } else {
+        menu_init(channel2_fields, sizeof(channel2_fields)/sizeof(MenuField_s));
     }
-    oled_send_chars(text, 6, 64, underscore_digit);
+    draw_main_screen();
+}
+
+/**
+ * Draws the clock trim page
+ */
+void draw_trim_page(void){
+    trim_draw_page();
+    menu_draw_labels();
+    menu_invalidate(MENU_ALL_FIELDS);
+    menu_draw();
 }
 
 /**
@@ -341,27 +473,9 @@ void update_batt_indicator(void){
     oled_send_buff(batt, 12, 0, 128-12);
 }
 
-/**
- * Converts a number to a string
- *
- * todo: rename function
- */
-int text_to_ascii(uint16_t n, char *text){
-    for(int i=0;i<=6;i++){text[i] = 0;}
-    uint8_t text_len = N_DIGITS-1;
-    while(1){
-        text[text_len] = (n % 10) + 0x30;
-        n /= 10;
-        if(text_len-- == 0){
-            break;
-        }
-    }
-    return text_len;
-}
-
 void tmp(uint16_t r){
-    char text[20];
-    text_to_ascii(r, text);
+    char text[MENU_TEXT_SIZE];
+    menu_format(r, MENU_FORMAT_NUMBER, 0xFF, text);
     oled_send_text(text, 2);
 }
 
@@ -396,6 +510,7 @@ void updateBatteryLevel(void){
 
     if(isCharging != lastChargeState){
         isCharging = lastChargeState;
+        TELEMETRY_SEND(TELEMETRY_BATTERY, 0, 0, currBattBar, isCharging);
         update_batt_indicator();
     }
 
@@ -428,77 +543,148 @@ void updateBatteryLevel(void){
         if(abs(res - lastStateADC) > 30){
             lastStateADC = res;
             currBattBar = newBatteryBar;
+            TELEMETRY_SEND(TELEMETRY_BATTERY, TELEMETRY_U16(res), currBattBar, isCharging);
             update_batt_indicator();
         }
     }
 }
 
 /**
- * Interrupt for timer. This gets triggered once every 1/125 seconds
+ * Steps the trigger state machine by one second. Gets called from the timer ISR, or from the main loop
+ * with the timer interrupt disabled while powered down
  */
-ISR(TIMER0_COMPA_vect){
+static void sequence_step(void){
+#ifdef TELEMETRY
+    TriggerMode_e prev_mode = sys.mode;
+#endif
+    TriggerMode_e prev_first = channels[0].mode;
+    int32_t prev_n_pic = channels[0].cur.n_pic;
+
+    // intentional as we don't want to update the screen if not in picture taking mode
+    if(sys.mode == TRIGGER_MODE_STANDBY){
+        return;
+    }
+    sys.mode = trigger_step(channels);
+    progress_step(prev_first, prev_n_pic, &channels[0]);
+    recovery_save(sys.mode, channels);
+
+#ifdef TELEMETRY
+    if(sys.mode != prev_mode){
+        TELEMETRY_SEND(TELEMETRY_STATE, sys.mode, TELEMETRY_U16(tick_count));
+    }
+#endif
+    sched_set_event(EVENT_SEQUENCE);
+}
+
+/**
+ * Returns the time until the first channel waiting for its start or window starts. A channel that ended
+ * still has its start delay, so only the scheduled ones count
+ */
+int32_t scheduled_delay(void){
+    int32_t delay = INT32_MAX;
+
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        if(channels[i].mode == TRIGGER_MODE_SCHEDULED && channels[i].cur.start_delay < delay){
+            delay = channels[i].cur.start_delay;
+        }
+    }
+    return delay;
+}
+
+/**
+ * Powers down until shortly before the scheduled start or the next window, with the watchdog keeping
+ * the time instead of TIMER0
+ *
+ * The display is turned off and nothing runs in the meantime. TIMER0 gets started again with the same
+ * fraction of a second left as the watchdog count, so the seconds carry on without a jump.
+ */
+void sleep_until_window(void){
+    uint32_t period;
+    uint32_t second = DEEPSLEEP_UNITS_PER_SECOND + trim_ppm;     // a second of the trimmed clock
+    uint32_t tick = second / 125;
+    uint32_t frac;      // time since the last second was stepped, in DEEPSLEEP units
+    uint8_t top;
+
+    oled_display_on(false);
+    period = (uint32_t)deepsleep_calibrate() * DEEPSLEEP_UNITS_PER_COUNT;
+
+    // calibrating returns right after a watchdog interrupt, so the watchdog takes over from here
+    cli();
+    TIMSK &= ~(1 << OCIE0A);
+    frac = timer_counter * tick + TCNT0L * DEEPSLEEP_UNITS_PER_COUNT;
+    sei();
+
+    deepsleep_start();
+    while(scheduled_delay() > DEEPSLEEP_RESYNC_SECONDS && sys.mode == TRIGGER_MODE_SCHEDULED){
+        deepsleep_wait();
+        for(frac += period; frac >= second; frac -= second){
+            sequence_step();
+        }
+        TELEMETRY_FLUSH();
+    }
+    deepsleep_end();
+
+    // carry on with TIMER0, from the same point in the second, with the running tick as long as the
+    // trimmed ones are on average
+    cli();
+    for(timer_counter = 0; frac >= tick; frac -= tick){
+        timer_counter++;
+    }
+    frac /= DEEPSLEEP_UNITS_PER_COUNT;
+    top = tick / DEEPSLEEP_UNITS_PER_COUNT - 1;
+    // the match right after writing the counter gets skipped, so it has to start below the top
+    OCR0A = top;
+    TCNT0H = 0;
+    TCNT0L = (frac < top) ? frac : top - 1;
+    TIFR = (1 << OCF0A);
+    TIMSK |= (1 << OCIE0A);
+    sei();
+
+    oled_display_on(true);
+}
+
+/**
+ * Handles the timer tick and the trigger state machine. This gets called once every 1/125 seconds
+ */
+static inline void timer_tick(void){
+#ifdef TELEMETRY
+    // the timer is in CTC mode, so the counter value is how long ago the compare match happened
+    static uint8_t max_latency = 0;
+    uint8_t latency = TCNT0L;
+    if(latency > max_latency){max_latency = latency;}
+#endif
+    trim_tick();
+    tick_count++;
+    sched_tick();
+    if(buttons_tick()){
+        sched_set_event(EVENT_INPUT);
+    }
     // Only actually do stuff here once the counter reaches one second
     if(++timer_counter != 125){return;}else{timer_counter = 0;}        
 
-    switch(sys.mode){
-        case TRIGGER_MODE_ARM:
-            blinking_led_var = !blinking_led_var;
-            if(blinking_led_var){TURN_ON_CYAN;}else{TURN_OFF_ALL_LED;}
-            if(shutter_trigger.tt != 0){shutter_trigger.tt--;}
-            if(shutter_trigger.tmlps_interv != 0){shutter_trigger.tmlps_interv--;}
-            if(shutter_trigger.tt == 0){
-                // TRIGGERED
-                TRIGGER_ON;
-                sys.mode = TRIGGER_MODE_TRIGGERED;
-            }
-            break;
-        case TRIGGER_MODE_TRIGGERED:
-            TURN_ON_BLUE_LED;
-            shutter_trigger.trt--;
-            if(shutter_trigger.tmlps_interv != 0){shutter_trigger.tmlps_interv--;}
-            if(shutter_trigger.trt == 0){
-                if(shutter_trigger.n_pic != 0){
-                    sys.mode = TRIGGER_MODE_WAITING_FOR_NEXT_PIC;
-                    shutter_trigger.n_pic--;
-                } else {
-                    // Trigger has stopped
-                    sys.mode = TRIGGER_MODE_END;
-                }
-                
-            }
-            break;
-        case TRIGGER_MODE_WAITING_FOR_NEXT_PIC:
-            TRIGGER_OFF; TURN_OFF_ALL_LED;
-            if(shutter_trigger.tmlps_interv == 0){
-                shutter_trigger.trt = old_shutter_trigger.trt;
-                shutter_trigger.tt = old_shutter_trigger.tt;
-                if(shutter_trigger.tt == 0){
-                    TRIGGER_ON;
-                    sys.mode = TRIGGER_MODE_TRIGGERED;
-                } else {
-                    sys.mode = TRIGGER_MODE_ARM;
-                }
-            } else {
-                shutter_trigger.tmlps_interv--;
-            }
-            break;
-        case TRIGGER_MODE_END:
-            TRIGGER_OFF;
-            TURN_OFF_ALL_LED;
-            memcpy(&shutter_trigger, &old_shutter_trigger, sizeof(shutter_trigger));
-            sys.mode = TRIGGER_MODE_STANDBY;
-            break;
-        default:
-            return; // intentional as we don't want to update the screen if not in picture taking mode
-    }
-
-    flagUpdateTrigTime = true;
+#ifdef TELEMETRY
+    TELEMETRY_SEND(TELEMETRY_TICK, TELEMETRY_U16(tick_count));
+    TELEMETRY_SEND(TELEMETRY_ISR_LATENCY, 0, TELEMETRY_U16(max_latency));
+    max_latency = 0;
+#endif
+
+    sequence_step();
 }
 
 /**
- * Interrupt for PortC, which is only for the rotary encoder
+ * Interrupt for timer. This gets triggered once every 1/125 seconds
  */
-ISR(PCINT_vect){
+ISR(TIMER0_COMPA_vect){
+    INSTRUMENT_ISR_ENTRY();
+    INSTRUMENT_T0_LATENCY();
+    timer_tick();
+    INSTRUMENT_ISR_EXIT(INSTRUMENT_ISR_TIMER0);
+}
+
+/**
+ * Handles a pin change, which is only for the rotary encoder
+ */
+static inline void encoder_pin_change(void){
     static uint8_t pvcv;       // Previous Value (XX) and Current Value (YY), 0bXXYY
     // static uint8_t last_val;   // the last rotary encoder pin values
 
@@ -511,30 +697,19 @@ ISR(PCINT_vect){
     _delay_loop_2(150);
 
     uint8_t r = READ_ROTARY_ENCODER_BIT;
-    // only update if the value of the rotary encoder has changed
-    // todo: wouldn't this always be the case anyways due to the interrupt?? test without
-    //if(r != encoder_vars.last_val){
-    //    encoder_vars.last_val = r;
-    pvcv = ((pvcv << 2) | r) & 0x0F;
-
-    switch(pvcv){
-        // case 0b0001:
-        case 0b1000:
-        case 0b0111:
-        // case 0b1110:
-            encoder_vars.dir = ROTARY_ENCODER_ROT_CW;
-            // switchDebounce = 10;
-            break;
-        // case 0b0010:
-        case 0b0100:
-        case 0b1011:
-        // case 0b1101:
-            encoder_vars.dir = ROTARY_ENCODER_ROT_CCW;
-            // switchDebounce = 10;
-            break;
-    }
-    //}
+    encoder_vars.dir = encoder_decode(&pvcv, r);
+    TELEMETRY_SEND(TELEMETRY_ENCODER, r, encoder_vars.dir, TELEMETRY_U16(tick_count), TCNT0L);
+    if(encoder_vars.dir != ROTARY_ENCODER_ROT_NOTHING){
+        sched_set_event(EVENT_INPUT);
+    }
     // clear the interrupt flag for PCIF
     GIFR |= (1 << PCIF);
 
 }
+
+ISR(PCINT_vect){
+    INSTRUMENT_ISR_ENTRY();
+    FLASHSYNC_EDGE();
+    encoder_pin_change();
+    INSTRUMENT_ISR_EXIT(INSTRUMENT_ISR_PCINT);
+}
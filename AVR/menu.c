@@ -0,0 +1,186 @@
+/**
+ * Camera Shutter Control Project, settings menu
+ * By Electro707, 2023
+ *
+ * The settings screen is driven by a table of fields in PROGMEM, which is used for both editing and
+ * drawing. Each field has a dirty bit so that a redraw only touches the fields that changed.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+#include <string.h>
+#include "menu.h"
+#include "oled.h"
+#include "trigger.h"
+
+// place value of each digit, starting from the ones
+const uint32_t tens_radix[N_DIGITS] PROGMEM = {1, 10, 100, 1000, 10000};
+const uint32_t hms_radix[N_HMS_DIGITS] PROGMEM = {1, 10, 60, 600, 3600, 36000, 360000};
+
+static const MenuField_s *menu_fields;
+static uint8_t menu_n_fields;
+static uint8_t selected = 0;        // index of the field being edited
+static uint8_t digit = 0;           // index of the digit being edited, 0 is the ones
+static uint8_t dirty = 0;           // fields that need to be redrawn
+
+/**
+ * Returns how many digits the selected field has
+ */
+static uint8_t menu_n_digits(void){
+    if(pgm_read_byte(&menu_fields[selected].format) == MENU_FORMAT_HMS){
+        return N_HMS_DIGITS;
+    }
+    return N_DIGITS;
+}
+
+void menu_init(const MenuField_s *fields, uint8_t n_fields){
+    menu_fields = fields;
+    menu_n_fields = n_fields;
+    selected = 0;
+    digit = 0;
+    dirty = MENU_ALL_FIELDS;
+}
+
+void menu_draw_labels(void){
+    for(uint8_t i=0;i<menu_n_fields;i++){
+        oled_send_chars_P(pgm_read_ptr(&menu_fields[i].label), pgm_read_byte(&menu_fields[i].line)-1, pgm_read_byte(&menu_fields[i].column));
+    }
+}
+
+/**
+ * Draws the values of all dirty fields
+ */
+void menu_draw(void){
+    char text[MENU_TEXT_SIZE];
+    uint8_t underscore_char;
+    uint8_t len;
+    int32_t *var;
+    int32_t value;
+
+    for(uint8_t i=0;i<menu_n_fields;i++){
+        if(!(dirty & (1 << i))){
+            continue;
+        }
+        dirty &= ~(1 << i);
+
+        var = pgm_read_ptr(&menu_fields[i].var);
+        // the variables get counted down from the timer ISR during a sequence
+        TRIGGER_READ(value = *var);
+
+        underscore_char = menu_format(value, pgm_read_byte(&menu_fields[i].format), (i == selected) ? digit : 0xFF, text);
+        len = strlen(text);
+        text[len] = pgm_read_byte(&menu_fields[i].unit);
+        text[len+1] = 0;
+        oled_send_chars(text, pgm_read_byte(&menu_fields[i].line), pgm_read_byte(&menu_fields[i].column), underscore_char);
+    }
+}
+
+void menu_invalidate(uint8_t mask){
+    dirty |= mask;
+}
+
+/**
+ * Moves the selection to the next field
+ */
+void menu_next_field(void){
+    dirty |= (1 << selected);
+    if(++selected >= menu_n_fields){
+        selected = 0;
+    }
+    if(digit >= menu_n_digits()){
+        digit = 0;
+    }
+    dirty |= (1 << selected);
+}
+
+/**
+ * Moves the selection to the next higher digit, wrapping around to the ones
+ */
+void menu_next_digit(void){
+    if(++digit >= menu_n_digits()){
+        digit = 0;
+    }
+    dirty |= (1 << selected);
+}
+
+/**
+ * Changes the selected field by one step of the selected digit, dir being 1 or -1
+ *
+ * Times are stepped by the digit's place value in seconds, so going past 59 minutes or seconds
+ * carries into the next unit
+ */
+void menu_change(int8_t dir){
+    int32_t *var = pgm_read_ptr(&menu_fields[selected].var);
+    int32_t min = pgm_read_dword(&menu_fields[selected].min);
+    int32_t max = pgm_read_dword(&menu_fields[selected].max);
+    const uint32_t *radix = tens_radix;
+    int32_t step;
+
+    if(pgm_read_byte(&menu_fields[selected].format) == MENU_FORMAT_HMS){
+        radix = hms_radix;
+    }
+    step = pgm_read_dword(&radix[digit]);
+    if(dir < 0){
+        // clamp before going past the minimum, as the variable can be anywhere up to INT32_MAX
+        *var = (*var - min < step) ? min : *var - step;
+    } else {
+        *var = (max - *var < step) ? max : *var + step;
+    }
+    dirty |= (1 << selected);
+}
+
+/**
+ * Converts a number to text in the given format, for the digits to line up it always has leading zeros
+ *
+ * This doesn't divide: each digit is found by subtracting its place value until what is left is smaller,
+ * which is at most 9 subtractions per digit. Numbers too large to show are shown as the largest one.
+ * Signed numbers are passed as their int32_t value.
+ * Returns the index of the character of underscore_digit (0 is the ones), or 0xFF for none
+ */
+uint8_t menu_format(uint32_t n, MenuFormat_e format, uint8_t underscore_digit, char *text){
+    const uint32_t *radix = tens_radix;
+    int8_t n_digits = N_DIGITS;
+    uint32_t max = MENU_NUMBER_MAX;
+    uint8_t underscore_char = 0xFF;
+    uint8_t c = 0;
+    uint32_t place;
+    char digit_char;
+
+    if(format == MENU_FORMAT_HMS){
+        radix = hms_radix;
+        n_digits = N_HMS_DIGITS;
+        max = MENU_HMS_MAX;
+    }
+    if(format == MENU_FORMAT_SIGNED){
+        text[c++] = ((int32_t)n < 0) ? '-' : '+';
+        if((int32_t)n < 0){
+            n = -(int32_t)n;
+        }
+    }
+    if(n > max){
+        n = max;
+    }
+
+    for(int8_t i=n_digits-1;i>=0;i--){
+        // separators go before the tens of minutes and of seconds
+        if(format == MENU_FORMAT_HMS && (i == 3 || i == 1)){
+            text[c++] = ':';
+        }
+        place = pgm_read_dword(&radix[i]);
+        digit_char = '0';
+        while(n >= place){
+            n -= place;
+            digit_char++;
+        }
+        if(i == underscore_digit){
+            underscore_char = c;
+        }
+        text[c++] = digit_char;
+    }
+    text[c] = 0;
+    return underscore_char;
+}
@@ -0,0 +1,56 @@
+/**
+ * Camera Shutter Control Project, settings menu
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef MENU_H
+#define MENU_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#define N_DIGITS    5               // digits of a number
+#define N_HMS_DIGITS 7              // digits of a time, shown as HHH:MM:SS
+#define MENU_TEXT_SIZE 11           // longest value text, with its unit and terminator
+#define MENU_ALL_FIELDS 0xFF        // dirty mask for redrawing every field
+
+#define MENU_NUMBER_MAX 99999L
+#define MENU_HMS_MAX (999*3600L + 59*60 + 59)
+
+/**
+ * How a field's value is shown and edited
+ */
+typedef enum{
+    MENU_FORMAT_NUMBER = 0,         // a plain number, with each digit edited on its own
+    MENU_FORMAT_HMS,                // a time in seconds, shown as hours, minutes and seconds
+    MENU_FORMAT_SIGNED,             // a number that can be negative, shown with its sign
+}MenuFormat_e;
+
+/**
+ * A settings field. The label is drawn on the line above the value
+ */
+typedef struct{
+    const char *label;      // label text, in PROGMEM
+    int32_t *var;           // the variable being edited
+    int32_t min;
+    int32_t max;
+    uint8_t line;           // line the value is drawn on
+    uint8_t column;         // starting column of both the label and value
+    char unit;              // unit shown after the value, or 0 for none
+    uint8_t format;         // a MenuFormat_e
+}MenuField_s;
+
+void menu_init(const MenuField_s *fields, uint8_t n_fields);
+void menu_draw_labels(void);
+void menu_draw(void);
+void menu_invalidate(uint8_t mask);
+void menu_next_field(void);
+void menu_next_digit(void);
+void menu_change(int8_t dir);
+uint8_t menu_format(uint32_t n, MenuFormat_e format, uint8_t underscore_digit, char *text);
+
+#endif
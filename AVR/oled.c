@@ -13,38 +13,153 @@
 
 void send_i2c_command(uint8_t i2cdata);
 
-void send_i2c_command(uint8_t i2cdata){
-    uint8_t to_send[] = {OLED_SLAVE_ADDR<<1, 0x00, i2cdata};
-    USI_TWI_Start_Transceiver_With_Data(to_send, 3);
+/**
+ * Everything oled_init() sends, as one transaction
+ */
+static const uint8_t oled_init_commands[] PROGMEM = {
+    0xAE,           // Set while display off
+    0xD5, 0x80,     // Set Display Clock Divide Ratio/Oscillator Frequency
+    0xA8, 0x3f,     // Set Multiplex Ratio
+    0xD3, 0x00,     // Set Display Offset
+    0x40 | 0x00,    // Set Display Start Line
+    0x20, 0x00,     // Set Memory Addressing Mode
+    0x8D, 0x14,     // Charge Pump Setting
+    0xA1,           // Set Segment Re-map
+    0xC8,           // Set COM Output Scan Direction
+    0xDA, 0x12,     // Set COM Pins Hardware Configuration
+    0x81, 0xcf,     // Set Contrast Control
+    0xD9, 0xF1,     // Set Pre-charge Period
+    0xDB, 0x40,     // Set VCOMH Deselect Level
+    0xA6,           // Normal display(not inverted)
+    0xA4,           // Turn display to follow ram
+};
+
+#ifdef INSTRUMENT
+uint16_t oled_tx_bytes = 0;
+#endif
+
+static uint8_t oled_bus_ok;        // cleared once a transfer fails, so the rest of the transaction is skipped
+static uint8_t oled_skipped;       // the transaction wasn't started, as the display is faulted
+static uint8_t oled_fault = 0;     // set when a transfer failed, until oled_recover() gets called
+
+/**
+ * All bus traffic to the display goes through these: a transaction is started with the address and a
+ * control byte, followed by any number of bytes, and ended with oled_stop()
+ *
+ * Once a transfer fails, everything sent to the display is dropped until oled_recover(), so a missing or
+ * stuck display costs no more than one bus timeout
+ */
+static void oled_start(uint8_t control){
+#ifdef INSTRUMENT
+    oled_tx_bytes += 2;
+#endif
+    oled_skipped = oled_fault;
+    oled_bus_ok = !oled_fault && USI_TWI_Start_Write(OLED_SLAVE_ADDR<<1) && USI_TWI_Write_Byte(control);
+    if(!oled_bus_ok){
+        oled_fault = 1;
+    }
 }
 
+static void oled_byte(uint8_t data){
+#ifdef INSTRUMENT
+    oled_tx_bytes++;
+#endif
+    if(oled_bus_ok){
+        oled_bus_ok = USI_TWI_Write_Byte(data);
+        if(!oled_bus_ok){
+            oled_fault = 1;
+        }
+    }
+}
 
-void oled_set_text_position(uint8_t col, uint8_t line){
-    send_i2c_command(0x21);//Set Column Address
-    send_i2c_command(col);
-    send_i2c_command(127);
-    send_i2c_command(0x22);//Set Page Address
-    send_i2c_command(line);
-    send_i2c_command(line);
+static void oled_stop(void){
+    if(!oled_skipped && !USI_TWI_Master_Stop()){
+        oled_fault = 1;
+    }
 }
 
-void oled_clear_display(){
-    uint8_t i2c_buff[10];
-    i2c_buff[0] = OLED_SLAVE_ADDR<<1;
-    i2c_buff[1] = 0x40;
-    for (uint8_t x=0; x<8; x++) {
-        i2c_buff[x+2] = 0x00;
+/**
+ * Returns true if talking to the display failed since the last oled_recover()
+ */
+bool oled_faulted(void){
+    return oled_fault;
+}
+
+/**
+ * Recovers the bus and re-initializes the display, which leaves it blank. Returns true if that worked
+ */
+bool oled_recover(void){
+    oled_fault = 0;
+    if(!USI_TWI_Bus_Recover()){
+        oled_fault = 1;
+        return false;
     }
+    oled_init();
+    oled_clear_display();
+    oled_display_on(true);
+    return !oled_fault;
+}
 
-    send_i2c_command(0x21);//Set Column Address
-    send_i2c_command(0x00);
-    send_i2c_command(127);
-    send_i2c_command(0x22);//Set Page Address
-    send_i2c_command(0x00);
-    send_i2c_command(7);
-    for (uint16_t i=0; i<128; i++) {
-        USI_TWI_Start_Transceiver_With_Data(i2c_buff, 10);
+/**
+ * Sends a payload after the control byte in a single transaction, straight from where it is stored
+ *
+ * With OLED_SRC_REPEAT the first payload byte gets sent len times
+ */
+void oled_transmit(uint8_t control, const uint8_t *payload, uint16_t len, OledSource_e source){
+    oled_start(control);
+    while(len--){
+        switch(source){
+            case OLED_SRC_PROGMEM:
+                oled_byte(pgm_read_byte(payload++));
+                break;
+            case OLED_SRC_REPEAT:
+                oled_byte(*payload);
+                break;
+            default:
+                oled_byte(*payload++);
+                break;
+        }
     }
+    oled_stop();
+}
+
+void send_i2c_command(uint8_t i2cdata){
+    oled_transmit(OLED_CONTROL_COMMAND, &i2cdata, 1, OLED_SRC_RAM);
+}
+
+/**
+ * Turns the display panel on or off, what is in its RAM is kept while it's off
+ */
+void oled_display_on(bool on){
+    send_i2c_command(on ? 0xAF : 0xAE);
+}
+
+void oled_set_area(uint8_t col_start, uint8_t col_end, uint8_t line_start, uint8_t line_end){
+    uint8_t commands[] = {
+        0x21, col_start, col_end,       // Set Column Address
+        0x22, line_start, line_end,     // Set Page Address
+    };
+    oled_transmit(OLED_CONTROL_COMMAND, commands, sizeof(commands), OLED_SRC_RAM);
+}
+
+void oled_set_text_position(uint8_t col, uint8_t line){
+    oled_set_area(col, 127, line, line);
+}
+
+/**
+ * Fills len columns of a line with the same byte, starting at column_start
+ *
+ * Useful for clearing part of a line or drawing bars
+ */
+void oled_fill(uint8_t pattern, uint8_t len, uint8_t starting_line, uint8_t column_start){
+    oled_set_text_position(column_start, starting_line);
+    oled_transmit(OLED_CONTROL_DATA, &pattern, len, OLED_SRC_REPEAT);
+}
+
+void oled_clear_display(){
+    uint8_t blank = 0x00;
+    oled_set_area(0, 127, 0, 7);
+    oled_transmit(OLED_CONTROL_DATA, &blank, OLED_SCREEN_BYTES, OLED_SRC_REPEAT);
 }
 
 void oled_send_text(char *text, uint8_t starting_line){
@@ -59,115 +174,98 @@ void oled_send_text_offset(char *text, uint8_t starting_line, uint8_t offset){
     oled_send_chars(text, starting_line, offset, 0);
 }
 
-void oled_send_chars(char *text, uint8_t starting_line, uint8_t column_start, uint8_t underscore_char){
-    uint8_t i2c_buff[8];
-    uint8_t k = 0;
-    uint8_t txt_per_line = 0;
+/**
+ * Draws text from RAM or PROGMEM, with the glyphs read straight from the font. Each line of text is sent
+ * as one transaction
+ */
+static void oled_draw_chars(const char *text, bool progmem, uint8_t starting_line, uint8_t column_start, uint8_t underscore_char){
+    const uint8_t *glyph;
+    uint8_t underscore;
     uint8_t current_line = starting_line;
-    oled_set_text_position(column_start, starting_line);
-
-    i2c_buff[0] = OLED_SLAVE_ADDR<<1;
-    i2c_buff[1] = 0x40;
-    i2c_buff[7] = 0x00;
+    char c;
 
-    uint8_t lenght = strlen(text);
-    for(uint8_t j=0;j<lenght;j++){
-        if(text[j] == '\n'){
+    oled_set_text_position(column_start, starting_line);
+    oled_start(OLED_CONTROL_DATA);
+    for(uint8_t j=0;(c = progmem ? pgm_read_byte(&text[j]) : text[j]);j++){
+        if(c == '\n'){
+            oled_stop();
             oled_set_text_position(column_start, ++current_line);
-            txt_per_line = 0;
-            continue;
-        }
-        if(text[j] == ' '){
-            for(k=0;k<5;k++){i2c_buff[k+2] = 0x00;}
-            USI_TWI_Start_Transceiver_With_Data(i2c_buff, 8);
-            txt_per_line++;
+            oled_start(OLED_CONTROL_DATA);
             continue;
         }
 
-        // todo: either verify below, or don't have it at all!
-        // if((++txt_per_line)*6 >= 125){
-        //     for(k=0;k<5;k++){i2c_buff[k+2] = pgm_read_byte_near(&font[k]);}
-        //     USI_TWI_Start_Transceiver_With_Data(i2c_buff, 8);
-        //     oled_set_text_position(column_start, ++current_line);
-        //     txt_per_line = 0;
-        // }
-
-        for(k=0;k<5;k++){i2c_buff[k+2] = pgm_read_byte_near(&font[(((text[j]-0x20) * 5) + k)]);}
-        if(underscore_char == j){
-            for(k=0;k<5;k++){i2c_buff[k+2] |= 1<<7;}
+        glyph = &font[(c-0x20) * 5];
+        underscore = (underscore_char == j) ? (1<<7) : 0;
+        for(uint8_t k=0;k<5;k++){
+            oled_byte(pgm_read_byte_near(glyph++) | underscore);
         }
-        USI_TWI_Start_Transceiver_With_Data(i2c_buff, 8);
-
+        oled_byte(0x00);    // gap between characters
     }
+    oled_stop();
 }
 
-// len must be <32
-void oled_send_buff(uint8_t *buff, uint8_t len, uint8_t starting_line, uint8_t column_start){
-    // todo: this can be optmized with i2c_buff not existing, look into I2C functions
-    uint8_t i2c_buff[32];
-    uint8_t *i2c_buff_p = i2c_buff;
-    uint8_t Blen = len;
+void oled_send_chars(char *text, uint8_t starting_line, uint8_t column_start, uint8_t underscore_char){
+    oled_draw_chars(text, false, starting_line, column_start, underscore_char);
+}
 
-    oled_set_text_position(column_start, starting_line);
+/**
+ * Same as oled_send_chars(), for text stored in PROGMEM
+ */
+void oled_send_chars_P(const char *text, uint8_t starting_line, uint8_t column_start){
+    oled_draw_chars(text, true, starting_line, column_start, 0xFF);
+}
 
-    *i2c_buff_p++ = OLED_SLAVE_ADDR<<1;
-    *i2c_buff_p++ = 0x40;
+void oled_send_text_P(const char *text, uint8_t starting_line){
+    oled_draw_chars(text, true, starting_line, 0, 0xFF);
+}
 
-    while(Blen--){
-        *i2c_buff_p++ = *buff++;
-    }
+void oled_send_buff(const uint8_t *buff, uint16_t len, uint8_t starting_line, uint8_t column_start){
+    oled_set_text_position(column_start, starting_line);
+    oled_transmit(OLED_CONTROL_DATA, buff, len, OLED_SRC_RAM);
+}
 
-    USI_TWI_Start_Transceiver_With_Data(i2c_buff, len+2);
+/**
+ * Same as oled_send_buff(), for bitmaps stored in PROGMEM
+ */
+void oled_send_buff_P(const uint8_t *buff, uint16_t len, uint8_t starting_line, uint8_t column_start){
+    oled_set_text_position(column_start, starting_line);
+    oled_transmit(OLED_CONTROL_DATA, buff, len, OLED_SRC_PROGMEM);
 }
 
+/**
+ * Sets up the display, leaving it off with whatever was in its RAM. Draw the screen and then turn it on
+ * with oled_display_on(), so the old contents never show
+ */
 void oled_init(){
-    send_i2c_command(0xAE);//Set while display off
-
-    send_i2c_command(0xD5);//Set Display Clock Divide Ratio/Oscillator Frequency
-    send_i2c_command(0x80);
-
-    send_i2c_command(0xA8);//Set Multiplex Ratio
-    send_i2c_command(0x3f);
-
-    send_i2c_command(0xD3);//Set Display Offset
-    send_i2c_command(0x00);
-
-    send_i2c_command(0x40 | 0x00);//Set Display Start Line
-
-    send_i2c_command(0x20);//Set Memory Addressing Mode
-    send_i2c_command(0x00);
-
-    send_i2c_command(0x8D);//Charge Pump Setting
-    send_i2c_command(0x14);
-
-    send_i2c_command(0xA1);//Set Segment Re-map
-
-    send_i2c_command(0xC8);//Set COM Output Scan Direction
-
-    send_i2c_command(0xDA);//Set COM Pins	Hardware Configuration
-    send_i2c_command(0x12);
-
-    send_i2c_command(0x81);//Set Contrast Control
-    send_i2c_command(0xcf);
-
-    send_i2c_command(0xD9);//Set Pre-charge Period
-    send_i2c_command(0xF1);
-
-    send_i2c_command(0xDB);//Set VCOMH Deselect Level
-    send_i2c_command(0x40);
-
-    send_i2c_command(0xA6);//Normal display(not inverted)
-
-    send_i2c_command(0x21);//Set Column Address
-    send_i2c_command(0x00);
-    send_i2c_command(127);
-
-    send_i2c_command(0x22);//Set Page Address
-    send_i2c_command(0x00);
-    send_i2c_command(7);
+    oled_transmit(OLED_CONTROL_COMMAND, oled_init_commands, sizeof(oled_init_commands), OLED_SRC_PROGMEM);
+}
 
-    oled_clear_display();
-    send_i2c_command(0xA5);//Turn whole display on
-    send_i2c_command(0xAF);//Display on
-    send_i2c_command(0xA4);//Turn display to follow ram
+/**
+ * Draws a whole screen from a run-length encoded image in PROGMEM, as one transaction. The image format
+ * is described in layout_gen.py
+ */
+void oled_send_layout(const uint8_t *image){
+    uint16_t left = OLED_SCREEN_BYTES;
+    uint8_t count, data;
+
+    oled_set_area(0, 127, 0, 7);
+    oled_start(OLED_CONTROL_DATA);
+    while(left){
+        count = pgm_read_byte(image++);
+        if(count & 0x80){
+            count = (count & 0x7F) + 1;
+            left -= count;
+            data = pgm_read_byte(image++);
+            while(count--){
+                oled_byte(data);
+            }
+        } else {
+            count++;
+            left -= count;
+            while(count--){
+                oled_byte(pgm_read_byte(image++));
+            }
+        }
+    }
+    oled_stop();
 }
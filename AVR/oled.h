@@ -11,25 +11,54 @@
 #define OLED_H
 
 #include <avr/io.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <string.h>
 #include "USI_TWI_Master.h"
 #include "letters.h"
 
 #define OLED_SLAVE_ADDR 0x3C
+#define OLED_SCREEN_BYTES (128*8)   // 128 columns of 8 lines, 8 pixels each
+
+// the control byte sent after the address says if the rest of the transaction is commands or display data
+#define OLED_CONTROL_COMMAND 0x00
+#define OLED_CONTROL_DATA 0x40
+
+/**
+ * Where oled_transmit() reads its payload from
+ */
+typedef enum{
+    OLED_SRC_RAM = 0,
+    OLED_SRC_PROGMEM,
+    OLED_SRC_REPEAT,        // the same RAM byte, repeated
+}OledSource_e;
 
 #define scrollspeed 75
 #define scrollspeedfast 5
 
+#ifdef INSTRUMENT
+extern uint16_t oled_tx_bytes;      // count of bytes sent to the display, including address and control bytes
+#endif
+
 void oled_init();
+bool oled_faulted(void);
+bool oled_recover(void);
+void oled_display_on(bool on);
+void oled_send_layout(const uint8_t *image);
+void oled_transmit(uint8_t control, const uint8_t *payload, uint16_t len, OledSource_e source);
 void oled_send_text(char *text, uint8_t starting_line);
 void oled_clear_display();
 void oled_set_text_position(uint8_t col, uint8_t line);
+void oled_set_area(uint8_t col_start, uint8_t col_end, uint8_t line_start, uint8_t line_end);
+void oled_fill(uint8_t pattern, uint8_t len, uint8_t starting_line, uint8_t column_start);
 void oled_send_text_underscore(char *text, uint8_t starting_line, uint8_t underscore_char);
 void oled_send_text_offset(char *text, uint8_t starting_line, uint8_t offset);
 
-void oled_send_buff(uint8_t *buff, uint8_t len, uint8_t starting_line, uint8_t column_start);
+void oled_send_buff(const uint8_t *buff, uint16_t len, uint8_t starting_line, uint8_t column_start);
+void oled_send_buff_P(const uint8_t *buff, uint16_t len, uint8_t starting_line, uint8_t column_start);
 
 void oled_send_chars(char *text, uint8_t starting_line, uint8_t column_start, uint8_t underscore_char);
+void oled_send_chars_P(const char *text, uint8_t starting_line, uint8_t column_start);
+void oled_send_text_P(const char *text, uint8_t starting_line);
 
 #endif
@@ -0,0 +1,183 @@
+/**
+ * Camera Shutter Control Project, sequence progress view
+ * By Electro707, 2023
+ *
+ * This replaces the settings screen while a sequence runs, showing how many pictures were taken, the
+ * elapsed time, the time left and a progress bar. Only what changed gets sent to the display: the
+ * numbers when their value moves, and the bar only the columns that got filled since the last draw.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include "progress.h"
+#include "oled.h"
+#include "menu.h"
+
+#define PROGRESS_VALUE_COLUMN (8*6)     // values start after the 8 character labels
+
+// column bitmaps of the progress bar
+#define BAR_CAP     0xFF
+#define BAR_EMPTY   0x81
+#define BAR_FILLED  0xBD
+
+static volatile Progress_s progress;
+
+static uint32_t total_seconds;          // length of the whole sequence
+static uint32_t total_frames;
+static uint32_t drawn_frames;
+static uint32_t drawn_elapsed;
+static uint8_t drawn_bar;               // filled bar columns on the display, 0xFF if the view isn't drawn yet
+
+/**
+ * Works out the length of a channel's sequence
+ *
+ * The first picture is taken after the start delay and the time to trigger (which takes at least a
+ * second), each following one an interval later, then the last one is held for the shutter time and the
+ * sequence takes one more second to end. Windows closing in between aren't counted
+ */
+static uint32_t sequence_length(const ShutterTriggerVars_s *settings){
+    uint32_t fixed = (uint32_t)settings->start_delay + (settings->tt ? settings->tt : 1) + settings->trt + 1;
+
+    // the longest settings don't fit in 32 bits, which is over a hundred years anyway
+    if(settings->n_pic != 0 && (uint32_t)settings->tmlps_interv > (UINT32_MAX - fixed) / settings->n_pic){
+        return UINT32_MAX;
+    }
+    return fixed + (uint32_t)settings->n_pic * settings->tmlps_interv;
+}
+
+/**
+ * Resets the counters and works out the length of the sequence, called after arming
+ *
+ * The sequence lasts as long as its longest channel. The pictures are counted on the first channel only
+ */
+void progress_start(const TriggerChannel_s *channels){
+    uint32_t length;
+
+    total_frames = channels[0].old.n_pic + 1;
+    total_seconds = 0;
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        length = sequence_length(&channels[i].old);
+        if(channels[i].mode != TRIGGER_MODE_STANDBY && length > total_seconds){
+            total_seconds = length;
+        }
+    }
+    drawn_bar = 0xFF;
+
+    // the timer ISR only counts while a sequence runs, which it doesn't yet
+    progress.elapsed = 0;
+    progress.frames = 0;
+}
+
+/**
+ * Same as progress_start(), but carries on from counters saved before a reset
+ */
+void progress_resume(const TriggerChannel_s *channels, const Progress_s *counters){
+    progress_start(channels);
+    progress.elapsed = counters->elapsed;
+    progress.frames = counters->frames;
+}
+
+/**
+ * Copies the counters, called from the timer ISR
+ */
+void progress_get(Progress_s *counters){
+    counters->elapsed = progress.elapsed;
+    counters->frames = progress.frames;
+}
+
+/**
+ * Counts a second of the sequence, called from the timer ISR after stepping the trigger state machine
+ * with the first channel's mode and picture count from before the step
+ *
+ * A picture counts once it's over and used up its count, as one the flash-sync didn't see gets taken
+ * again without using it up
+ */
+void progress_step(TriggerMode_e prev_mode, int32_t prev_n_pic, const TriggerChannel_s *first){
+    progress.elapsed++;
+    if(prev_mode == TRIGGER_MODE_TRIGGERED && first->mode != TRIGGER_MODE_TRIGGERED
+       && (first->mode == TRIGGER_MODE_END || first->cur.n_pic != prev_n_pic)){
+        progress.frames++;
+    }
+}
+
+/**
+ * Draws a number or a time in the value column
+ */
+static void draw_value(uint32_t n, uint8_t line, MenuFormat_e format){
+    char text[MENU_TEXT_SIZE];
+
+    menu_format(n, format, 0xFF, text);
+    oled_send_chars(text, line, PROGRESS_VALUE_COLUMN, 0xFF);
+}
+
+/**
+ * Draws the labels and an empty bar over the settings screen. The battery indicator is left alone
+ */
+static void draw_layout(void){
+    oled_fill(0x00, 128-12, 0, 0);
+    for(uint8_t l=1;l<8;l++){
+        oled_fill(0x00, 128, l, 0);
+    }
+    oled_send_text_P(PSTR("Running"), 0);
+    oled_send_text_P(PSTR("Done\nLeft\nElapsed\nETA"), 2);
+
+    oled_fill(BAR_CAP, 1, PROGRESS_BAR_LINE, 0);
+    oled_fill(BAR_EMPTY, PROGRESS_BAR_WIDTH, PROGRESS_BAR_LINE, 1);
+    oled_fill(BAR_CAP, 1, PROGRESS_BAR_LINE, PROGRESS_BAR_WIDTH+1);
+
+    drawn_bar = 0;
+    drawn_frames = 0xFFFFFFFF;
+    drawn_elapsed = 0xFFFFFFFF;
+}
+
+/**
+ * Makes the next progress_draw() draw the whole view again
+ */
+void progress_invalidate(void){
+    drawn_bar = 0xFF;
+}
+
+/**
+ * Updates the progress view, drawing it first if needed
+ */
+void progress_draw(void){
+    Progress_s now;
+    uint32_t left, scaled_elapsed, scaled_total;
+    uint8_t bar;
+
+    if(drawn_bar == 0xFF){
+        draw_layout();
+    }
+
+    TRIGGER_READ(now = progress);
+
+    if(now.frames != drawn_frames){
+        drawn_frames = now.frames;
+        draw_value(now.frames, 2, MENU_FORMAT_NUMBER);
+        draw_value((now.frames < total_frames) ? (total_frames - now.frames) : 0, 3, MENU_FORMAT_NUMBER);
+    }
+
+    if(now.elapsed != drawn_elapsed){
+        drawn_elapsed = now.elapsed;
+        left = (now.elapsed < total_seconds) ? (total_seconds - now.elapsed) : 0;
+        draw_value(now.elapsed, 4, MENU_FORMAT_HMS);
+        draw_value(left, 5, MENU_FORMAT_HMS);
+
+        // scale both down so the multiplication below can't overflow on very long sequences
+        scaled_elapsed = (now.elapsed < total_seconds) ? now.elapsed : total_seconds;
+        scaled_total = total_seconds;
+        while(scaled_total > 0x00FFFFFF){
+            scaled_elapsed >>= 1;
+            scaled_total >>= 1;
+        }
+        bar = (scaled_elapsed * PROGRESS_BAR_WIDTH) / scaled_total;
+        if(bar > drawn_bar){
+            // the bar only ever grows, so only the newly filled columns get sent
+            oled_fill(BAR_FILLED, bar - drawn_bar, PROGRESS_BAR_LINE, drawn_bar+1);
+            drawn_bar = bar;
+        }
+    }
+}
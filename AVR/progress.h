@@ -0,0 +1,34 @@
+/**
+ * Camera Shutter Control Project, sequence progress view
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef PROGRESS_H
+#define PROGRESS_H
+
+#include <avr/io.h>
+#include "trigger.h"
+
+#define PROGRESS_BAR_LINE 7
+#define PROGRESS_BAR_WIDTH 126      // fillable columns, between the two end caps
+
+/**
+ * Counters kept by the timer ISR while a sequence runs
+ */
+typedef struct{
+    uint32_t elapsed;       // seconds since arming
+    uint32_t frames;        // pictures that have been taken
+}Progress_s;
+
+void progress_start(const TriggerChannel_s *channels);
+void progress_step(TriggerMode_e prev_mode, int32_t prev_n_pic, const TriggerChannel_s *first);
+void progress_resume(const TriggerChannel_s *channels, const Progress_s *counters);
+void progress_get(Progress_s *counters);
+void progress_draw(void);
+void progress_invalidate(void);
+
+#endif
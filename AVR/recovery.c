@@ -0,0 +1,86 @@
+/**
+ * Camera Shutter Control Project, watchdog recovery
+ * By Electro707, 2023
+ *
+ * This supervises the main loop with the watchdog. If the main loop ever hangs, the watchdog resets
+ * the MCU and a sequence that was running gets picked back up from the state saved before the reset,
+ * so a hang costs at most a second of the sequence instead of the rest of it.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <stddef.h>
+#include <string.h>
+#include "recovery.h"
+
+#define RECOVERY_CHECK_SEED 0x5A
+
+// both are left alone by the C start-up code, so they survive a reset
+static RecoveryState_s saved RECOVERY_NOINIT;
+static uint8_t reset_flags RECOVERY_NOINIT;
+
+/**
+ * Runs before main(). After a watchdog reset the watchdog is still enabled with its shortest timeout,
+ * so it has to be turned off before the start-up code gets a chance to be slower than that
+ */
+void recovery_early_init(void) __attribute__((naked, used, section(".init3")));
+void recovery_early_init(void){
+    reset_flags = MCUSR;
+    MCUSR = 0;
+    wdt_disable();
+}
+
+static uint8_t check_add(uint8_t check, const void *data, uint8_t len){
+    const uint8_t *p = data;
+
+    while(len--){
+        check = (check << 1 | check >> 7) ^ *p++;
+    }
+    return check;
+}
+
+/**
+ * Checks the saved state and what changes in the channels while a sequence runs. Their settings don't
+ * change once armed, so they're left out to keep this short, as it runs in the timer ISR
+ */
+static uint8_t recovery_check(const TriggerChannel_s *channels){
+    uint8_t check = check_add(RECOVERY_CHECK_SEED, &saved, offsetof(RecoveryState_s, check));
+
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        check = check_add(check, &channels[i].mode, sizeof(channels[i].mode));
+        check = check_add(check, &channels[i].cur, sizeof(channels[i].cur));
+    }
+    return check;
+}
+
+void recovery_init(void){
+    wdt_enable(RECOVERY_WDT_TIMEOUT);
+}
+
+/**
+ * Saves the sequence state, called from the timer ISR every time the sequence steps
+ */
+void recovery_save(TriggerMode_e mode, const TriggerChannel_s *channels){
+    saved.mode = mode;
+    progress_get(&saved.progress);
+    saved.check = recovery_check(channels);
+}
+
+/**
+ * Returns true, with the saved state, if the last reset was from the watchdog in the middle of a sequence.
+ * The channels are then still as they were at the last save, otherwise they're garbage
+ */
+bool recovery_restore(const TriggerChannel_s *channels, RecoveryState_s *state){
+    bool valid = (reset_flags & (1 << WDRF)) && saved.check == recovery_check(channels)
+                 && saved.mode != TRIGGER_MODE_STANDBY;
+
+    if(valid){
+        memcpy(state, &saved, sizeof(*state));
+    }
+    saved.check = ~saved.check;      // only resume once
+    return valid;
+}
@@ -0,0 +1,45 @@
+/**
+ * Camera Shutter Control Project, watchdog recovery
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef RECOVERY_H
+#define RECOVERY_H
+
+#include <avr/io.h>
+#include <avr/wdt.h>
+#include <stdbool.h>
+#include "trigger.h"
+#include "progress.h"
+
+/**
+ * The watchdog resets the MCU if the main loop doesn't kick it for this long. The trigger sequence is
+ * stepped from the timer ISR, so it keeps running while the main loop is stuck. The channels are kept in
+ * RAM that isn't cleared on reset (RECOVERY_NOINIT), and every second the rest of the sequence state is
+ * saved next to them along with a check of their modes and counters, so the sequence carries on after
+ * the watchdog reset.
+ */
+#define RECOVERY_WDT_TIMEOUT WDTO_1S
+
+#define RECOVERY_NOINIT __attribute__((section(".noinit")))
+
+/**
+ * The sequence state saved along with the channels
+ */
+typedef struct{
+    TriggerMode_e mode;
+    Progress_s progress;
+    uint8_t check;          // of the above, and the modes and counters of the channels
+}RecoveryState_s;
+
+void recovery_init(void);
+void recovery_save(TriggerMode_e mode, const TriggerChannel_s *channels);
+bool recovery_restore(const TriggerChannel_s *channels, RecoveryState_s *state);
+
+#define RECOVERY_KICK() wdt_reset()
+
+#endif
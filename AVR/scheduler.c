@@ -0,0 +1,90 @@
+/**
+ * Camera Shutter Control Project, task scheduler
+ * By Electro707, 2023
+ *
+ * This is a tiny cooperative scheduler. Tasks are listed in a table in PROGMEM, in priority order, and
+ * are run from the main loop whenever one of their events is pending. Events get set either by the
+ * timer tick (for periodic tasks) or by anything else calling sched_set_event(), including ISRs.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+#include "scheduler.h"
+#include "sysclk.h"
+
+static const Task_s *sched_tasks;
+static uint8_t sched_n_tasks;
+static uint8_t countdown[SCHED_MAX_TASKS];      // ticks until a periodic task's events get set
+static volatile uint8_t pending = 0;            // pending events
+
+void sched_init(const Task_s *tasks, uint8_t n_tasks){
+    sched_tasks = tasks;
+    sched_n_tasks = n_tasks;
+    for(uint8_t i=0;i<n_tasks;i++){
+        countdown[i] = pgm_read_byte(&tasks[i].period);
+        pending |= pgm_read_byte(&tasks[i].events);     // run everything once on start-up
+    }
+}
+
+/**
+ * Gets called from the timer ISR on every tick
+ */
+void sched_tick(void){
+    for(uint8_t i=0;i<sched_n_tasks;i++){
+        if(countdown[i] != 0 && --countdown[i] == 0){
+            countdown[i] = pgm_read_byte(&sched_tasks[i].period);
+            pending |= pgm_read_byte(&sched_tasks[i].events);
+        }
+    }
+}
+
+void sched_set_event(uint8_t events){
+    uint8_t sreg = SREG;
+    cli();
+    pending |= events;
+    SREG = sreg;
+}
+
+/**
+ * Runs every task that has a pending event, in table order
+ *
+ * Input is first in the table, and as events are re-checked after every task, a slow task can only
+ * delay the input task by its own run time. Tasks run at full clock speed, unless they're flagged with
+ * SCHED_ANY_CLOCK
+ */
+void sched_run(void){
+    for(uint8_t i=0;i<sched_n_tasks;i++){
+        uint8_t events = pgm_read_byte(&sched_tasks[i].events);
+        cli();
+        events &= pending;
+        pending &= ~events;
+        sei();
+        if(events){
+            if(!(pgm_read_byte(&sched_tasks[i].flags) & SCHED_ANY_CLOCK)){
+                sysclk_full();
+            }
+            ((void (*)(void))pgm_read_ptr(&sched_tasks[i].run))();
+            i = 0xFF;       // start again from the highest priority task
+        }
+    }
+}
+
+/**
+ * Sleeps until the next interrupt if there are no pending events
+ */
+void sched_sleep(void){
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    cli();
+    if(pending == 0){
+        sleep_enable();
+        sei();
+        sleep_cpu();
+        sleep_disable();
+    }
+    sei();
+}
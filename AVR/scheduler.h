@@ -0,0 +1,48 @@
+/**
+ * Camera Shutter Control Project, task scheduler
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <avr/io.h>
+#include <avr/pgmspace.h>
+
+#define SCHED_MAX_TASKS 8
+
+/**
+ * Event flags. A task runs when any of the events in its mask are pending
+ */
+#define EVENT_INPUT     (1 << 0)        // buttons and rotary encoder need handling
+#define EVENT_DISPLAY   (1 << 1)        // the settings on the display need to be redrawn
+#define EVENT_BATTERY   (1 << 2)        // the battery level needs to be checked
+#define EVENT_SEQUENCE  (1 << 3)        // the trigger sequence has stepped
+#define EVENT_DIAG      (1 << 4)        // the diagnostics page needs to be refreshed
+#define EVENT_RECOVER   (1 << 5)        // the display needs to be checked for bus faults
+
+/**
+ * A task in the task table. Tasks with a non-zero period also get their events set every period ticks
+ */
+typedef struct{
+    void (*run)(void);
+    uint8_t events;     // events this task runs on
+    uint8_t period;     // in ticks, or 0 for only running on events
+    uint8_t flags;      // SCHED_* flags
+}Task_s;
+
+#define SCHED_ANY_CLOCK (1 << 0)    // the task can run in slow mode, so the clock is left as it is
+
+extern uint16_t tick_count;     // free running count of TIMER0 ticks, kept by main.c
+
+void sched_init(const Task_s *tasks, uint8_t n_tasks);
+void sched_tick(void);
+void sched_set_event(uint8_t events);
+void sched_run(void);
+void sched_sleep(void);
+
+#endif
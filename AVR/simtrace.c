@@ -0,0 +1,81 @@
+/**
+ * Camera Shutter Control Project, simulator traces
+ * By Electro707, 2023
+ *
+ * When built for simavr (with SIMAVR defined, see the trace target in the makefile), this tells the
+ * simulator which MCU to run and which pins to record into a VCD file, to check the timing of the
+ * shutter lines without a logic analyzer. The metadata goes in the .mmcu section, which isn't
+ * programmed into the MCU.
+ *
+ * The trace build arms with the settings in simtrace.h on start-up, marks when it did on GPIOR0, and
+ * ends the simulation once the sequence is over, so the trace can be checked by trace_check.py.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+#ifndef F_CPU
+#define F_CPU 8000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/sleep.h>
+
+#ifdef SIMAVR
+
+#include "avr_mcu_section.h"
+#include "board.h"
+#include "USI_TWI_Master.h"
+#include "simtrace.h"
+
+AVR_MCU(F_CPU, "attiny861");
+AVR_MCU_VCD_FILE("trace.vcd", 1000);
+
+// nothing references these, so they have to be kept from being optimized out
+const struct avr_mmcu_vcd_trace_t simtrace_pins[] _MMCU_ __attribute__((used)) = {
+    { AVR_MCU_VCD_SYMBOL("SHUTTER_PA0"), .mask = TRIGGER_PIN(0), .what = (void*)&PORTA, },
+    { AVR_MCU_VCD_SYMBOL("SHUTTER_PA1"), .mask = TRIGGER_PIN(1), .what = (void*)&PORTA, },
+    { AVR_MCU_VCD_SYMBOL("LED_RED"), .mask = (1 << 1), .what = (void*)&LED_PORT, },      // PB1, also telemetry or flash-sync
+    { AVR_MCU_VCD_SYMBOL("LED_GREEN"), .mask = LED_GREEN_PIN, .what = (void*)&LED_PORT, },
+    { AVR_MCU_VCD_SYMBOL("LED_BLUE"), .mask = LED_BLUE_PIN, .what = (void*)&LED_PORT, },
+    { AVR_MCU_VCD_SYMBOL("SDA"), .mask = (1 << PIN_USI_SDA), .what = (void*)&PIN_USI, },
+    { AVR_MCU_VCD_SYMBOL("SCL"), .mask = (1 << PIN_USI_SCL), .what = (void*)&PIN_USI, },
+    { AVR_MCU_VCD_SYMBOL("USIDR"), .what = (void*)&USIDR, },
+    { AVR_MCU_VCD_SYMBOL("ARMED"), .mask = 1, .what = (void*)&GPIOR0, },
+};
+
+/**
+ * Sets the settings of both channels to the ones in simtrace.h
+ */
+void simtrace_settings(TriggerChannel_s *channels){
+    channels[0].cur.tt = SIMTRACE_TT0;
+    channels[0].cur.trt = SIMTRACE_TRT0;
+    channels[0].cur.n_pic = SIMTRACE_NPIC0;
+    channels[0].cur.tmlps_interv = SIMTRACE_INTERV0;
+    channels[0].cur.start_delay = 0;
+    channels[0].cur.window = 0;
+    channels[1].cur.tt = SIMTRACE_TT1;
+    channels[1].cur.trt = SIMTRACE_TRT1;
+    channels[1].cur.n_pic = SIMTRACE_NPIC1;
+    channels[1].cur.tmlps_interv = SIMTRACE_INTERV1;
+}
+
+/**
+ * Marks the time the sequence got armed in the trace, which the shutter edges are timed from. GPIOR0
+ * isn't used by the firmware otherwise
+ */
+void simtrace_armed(void){
+    GPIOR0 = 1;
+}
+
+/**
+ * Ends the simulation, which simavr does once the MCU goes to sleep with interrupts disabled
+ */
+void simtrace_end(void){
+    cli();
+    sleep_enable();
+    sleep_cpu();
+}
+
+#endif
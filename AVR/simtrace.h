@@ -0,0 +1,34 @@
+/**
+ * Camera Shutter Control Project, simulator traces
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef SIMTRACE_H
+#define SIMTRACE_H
+
+#include "trigger.h"
+
+/**
+ * The settings the trace build arms with on start-up, as nothing presses the buttons in the simulator.
+ * trace_check.py reads them from here to work out when the shutter edges should be. They are kept short
+ * so the simulation only takes seconds, and the second channel runs its own settings so both lines get
+ * checked
+ */
+#define SIMTRACE_TT0 2
+#define SIMTRACE_TRT0 1
+#define SIMTRACE_NPIC0 2
+#define SIMTRACE_INTERV0 4
+#define SIMTRACE_TT1 1
+#define SIMTRACE_TRT1 2
+#define SIMTRACE_NPIC1 1
+#define SIMTRACE_INTERV1 5
+
+void simtrace_settings(TriggerChannel_s *channels);
+void simtrace_armed(void);
+void simtrace_end(void);
+
+#endif
@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""
+Camera Shutter Control Project, size budget check
+
+Checks the flash and RAM usage of the firmware against the limits in a budget file, and lists how
+much each function and variable grew or shrank against a checked-in size record. Exits with an error
+if anything is over budget.
+
+    ./size_budget.py build/out.elf size_budget.txt --record size_record.txt
+    ./size_budget.py build/out.elf size_budget.txt --record size_record.txt --update
+
+The budget file has one "<name> <bytes>" limit per line, where the name is either "flash", "ram" or
+the name of a symbol. The record file is rewritten with --update, so committing it along with a
+change shows what the change costs. Without --update, a missing record only gets a warning, so a tree
+that hasn't had one committed yet still builds.
+
+This program is free software: you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+"""
+import argparse
+import subprocess
+import sys
+
+RAM_START = 0x800000        # avr-gcc puts the data address space at this offset
+
+# nm symbol type -> memory the symbol takes up. Initialized data takes up both, as its initial
+# values are copied from flash at startup
+REGIONS = {
+    "t": ("flash",),
+    "w": ("flash",),
+    "d": ("flash", "ram"),
+    "b": ("ram",),
+}
+
+
+def read_symbols(nm, elf):
+    """Returns a dictionary of symbol name -> (region, size)"""
+    out = subprocess.run([nm, "-S", "-t", "d", "--size-sort", elf],
+                         check=True, capture_output=True, text=True).stdout
+    symbols = {}
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) != 4:
+            continue
+        addr, size, kind, name = int(fields[0]), int(fields[1]), fields[2].lower(), fields[3]
+        if kind not in REGIONS:
+            continue
+        # PROGMEM tables show up as data symbols, but live in flash
+        if kind in "db" and addr < RAM_START:
+            kind = "t"
+        symbols[name] = ("+".join(REGIONS[kind]), size)
+    return symbols
+
+
+def read_totals(size, elf):
+    """Returns the total flash and RAM usage from the section sizes"""
+    out = subprocess.run([size, "-A", elf], check=True, capture_output=True, text=True).stdout
+    sections = {}
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[0].startswith("."):
+            sections[fields[0]] = int(fields[1])
+    flash = sections.get(".text", 0) + sections.get(".data", 0)
+    ram = sections.get(".data", 0) + sections.get(".bss", 0) + sections.get(".noinit", 0)
+    return {"flash": flash, "ram": ram}
+
+
+def read_limits(name):
+    limits = {}
+    with open(name) as f:
+        for line in f:
+            line = line.split("#")[0].strip()
+            if line:
+                key, value = line.split()
+                limits[key] = int(value)
+    return limits
+
+
+def read_record(name):
+    """Returns the symbol sizes from a previous record, or None if there isn't one yet"""
+    record = {}
+    try:
+        with open(name) as f:
+            for line in f:
+                fields = line.split()
+                if len(fields) == 3:
+                    record[fields[2]] = (fields[0], int(fields[1]))
+    except FileNotFoundError:
+        return None
+    return record
+
+
+def write_record(name, totals, symbols):
+    with open(name, "w") as f:
+        f.write("# generated by size_budget.py, region size name\n")
+        for key, value in totals.items():
+            f.write("total {} {}\n".format(value, key))
+        for sym, (region, size) in sorted(symbols.items(), key=lambda s: (-s[1][1], s[0])):
+            f.write("{} {} {}\n".format(region, size, sym))
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("elf", help="linked firmware")
+    parser.add_argument("budget", help="budget file with the size limits")
+    parser.add_argument("--record", help="size record to compare against")
+    parser.add_argument("--update", action="store_true", help="rewrite the size record with this build")
+    parser.add_argument("--nm", default="avr-nm")
+    parser.add_argument("--size", default="avr-size")
+    args = parser.parse_args()
+
+    symbols = read_symbols(args.nm, args.elf)
+    totals = read_totals(args.size, args.elf)
+    limits = read_limits(args.budget)
+    over = False
+
+    # changes against the last record
+    if args.record:
+        record = read_record(args.record)
+        if record is None:
+            if not args.update:
+                print("warning: no size record in {}, run \"make budget-update\" and commit it".format(args.record))
+            record = {}
+        current = dict(symbols)
+        current.update((key, ("total", value)) for key, value in totals.items())
+        for sym in sorted(set(current) | set(record)):
+            old = record.get(sym, ("", 0))[1]
+            new = current.get(sym, ("", 0))[1]
+            if new != old:
+                print("{:>6} {:+6} {}".format(new, new - old, sym))
+
+    for key, limit in sorted(limits.items()):
+        if key in totals:
+            used = totals[key]
+        elif key in symbols:
+            used = symbols[key][1]
+        else:
+            continue
+        flag = ""
+        if used > limit:
+            flag = " OVER BUDGET"
+            over = True
+        print("{:12s} {:>5} / {:>5} bytes{}".format(key, used, limit, flag))
+
+    if args.update and args.record:
+        write_record(args.record, totals, symbols)
+
+    if over:
+        sys.exit(1)
+
+
+if __name__ == "__main__":
+    main()
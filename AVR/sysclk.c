@@ -0,0 +1,55 @@
+/**
+ * Camera Shutter Control Project, system clock scaling
+ * By Electro707, 2023
+ *
+ * This switches the system clock between full speed and a slow mode used while waiting between
+ * pictures, which cuts the active and idle current during long timelapses.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "sysclk.h"
+
+static volatile uint8_t is_slow = 0;     // also switched from ISRs, through ir_fire()
+
+/**
+ * Switches the system clock and Timer0's prescaler together
+ *
+ * Timer0's prescaler is shared and free running, so switching at any point would gain or lose part of a
+ * count. Instead the switch happens right after Timer0 counts, and its prescaler gets reset, which only
+ * loses the few cycles it takes to see the count change: a few full speed cycles when slowing down, and
+ * under half a count when speeding up
+ */
+static void sysclk_set(uint8_t slow, uint8_t clkps, uint8_t timer0_cs){
+    uint8_t sreg = SREG;
+    uint8_t count;
+
+    cli();
+    if(is_slow != slow){
+        count = TCNT0L;
+        while(TCNT0L == count);
+        // the prescaler change has to happen within 4 cycles of enabling it
+        CLKPR = (1 << CLKPCE);
+        CLKPR = clkps;
+        TCCR0B = timer0_cs;
+        GTCCR = (1 << PSR0);
+        is_slow = slow;
+    }
+    SREG = sreg;
+}
+
+void sysclk_full(void){
+    sysclk_set(0, 0, SYSCLK_TIMER0_FULL);
+}
+
+void sysclk_slow(void){
+    // Timer1 is used to time the ISRs when instrumenting, which would be off in slow mode. simavr doesn't
+    // model the clock prescaler, so only Timer0's would change there
+#if !defined(INSTRUMENT) && !defined(SIMAVR)
+    sysclk_set(1, SYSCLK_SLOW_DIV, SYSCLK_TIMER0_SLOW);
+#endif
+}
@@ -0,0 +1,32 @@
+/**
+ * Camera Shutter Control Project, system clock scaling
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef SYSCLK_H
+#define SYSCLK_H
+
+#include <avr/io.h>
+
+/**
+ * In slow mode the system clock is divided by 32 (250kHz), and Timer0's prescaler goes from 256 to 8 so
+ * that it keeps counting at 32us per count, keeping the 125Hz tick unchanged.
+ *
+ * Everything that depends on cycle counts (the telemetry UART and the IR carrier) has to run at full
+ * speed, which is done by calling sysclk_full() before using them. The I2C bus only gets slower, which
+ * is fine for a few bytes, but a whole screen needs full speed to fit within the watchdog timeout.
+ * Each switch loses a little time (see sysclk_set()), so they're kept to what a picture and the progress
+ * view need.
+ */
+#define SYSCLK_SLOW_DIV 0b0101          // CLKPS value, /32
+#define SYSCLK_TIMER0_FULL 0b100        // CS0 value, /256
+#define SYSCLK_TIMER0_SLOW 0b010        // CS0 value, /8
+
+void sysclk_full(void);
+void sysclk_slow(void);
+
+#endif
@@ -0,0 +1,95 @@
+/**
+ * Camera Shutter Control Project, telemetry module
+ * By Electro707, 2023
+ *
+ * This is a transmit-only software UART used to stream debug records out of the device. Records are
+ * queued into a small FIFO (which is safe to do from an interrupt) and are bit-banged out from the main
+ * loop with telemetry_flush(), so the ISRs never wait on the serial line.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+#ifndef F_CPU
+#define F_CPU 8000000
+#endif
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include "telemetry.h"
+#include "sysclk.h"
+
+#ifdef TELEMETRY
+
+// cycles per bit, minus the approximate overhead of the bit loop
+#define TELEMETRY_BIT_CYCLES ((F_CPU / TELEMETRY_BAUD) - 8)
+
+static uint8_t fifo[TELEMETRY_FIFO_SIZE];
+static volatile uint8_t fifo_head = 0;     // next index to write to
+static volatile uint8_t fifo_tail = 0;     // next index to read from
+
+void telemetry_init(void){
+    DDRB |= TELEMETRY_PIN;
+    TELEMETRY_PORT |= TELEMETRY_PIN;    // idle high
+}
+
+/**
+ * Queues a frame to be sent. If there is not enough room for the whole frame, it is dropped
+ */
+void telemetry_send(TelemetryType_e type, uint8_t *payload, uint8_t len){
+    uint8_t sreg = SREG;
+    uint8_t head;
+    uint8_t checksum = type;
+
+    cli();
+    head = fifo_head;
+    if(((fifo_tail - head - 1) & (TELEMETRY_FIFO_SIZE-1)) < (len + 3)){
+        SREG = sreg;
+        return;
+    }
+    fifo[head++ & (TELEMETRY_FIFO_SIZE-1)] = TELEMETRY_SYNC;
+    fifo[head++ & (TELEMETRY_FIFO_SIZE-1)] = type;
+    while(len--){
+        checksum += *payload;
+        fifo[head++ & (TELEMETRY_FIFO_SIZE-1)] = *payload++;
+    }
+    fifo[head++ & (TELEMETRY_FIFO_SIZE-1)] = checksum;
+    fifo_head = head & (TELEMETRY_FIFO_SIZE-1);
+    SREG = sreg;
+}
+
+/**
+ * Sends a single byte, 8N1. Interrupts are disabled for the byte's duration (~520us at 19200 baud)
+ * so the bit timing stays intact, which is well within one 8ms timer tick.
+ */
+static void telemetry_send_byte(uint8_t b){
+    uint8_t sreg = SREG;
+    uint16_t frame = ((uint16_t)b << 1) | (1 << 9);     // start bit, data, stop bit
+
+    cli();
+    for(uint8_t i=0;i<10;i++){
+        if(frame & 1){
+            TELEMETRY_PORT |= TELEMETRY_PIN;
+        } else {
+            TELEMETRY_PORT &= ~TELEMETRY_PIN;
+        }
+        frame >>= 1;
+        __builtin_avr_delay_cycles(TELEMETRY_BIT_CYCLES);
+    }
+    SREG = sreg;
+}
+
+/**
+ * Sends out everything that is queued up. Call from the main loop
+ */
+void telemetry_flush(void){
+    if(fifo_tail != fifo_head){
+        sysclk_full();      // the bit timing is in full speed cycles
+    }
+    while(fifo_tail != fifo_head){
+        telemetry_send_byte(fifo[fifo_tail]);
+        fifo_tail = (fifo_tail + 1) & (TELEMETRY_FIFO_SIZE-1);
+    }
+}
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * Camera Shutter Control Project, telemetry module
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <avr/io.h>
+
+/**
+ * The telemetry stream is a software UART (8N1) transmitted on PB1, which is the PROG_MISO pin on the
+ * ISP header (J2). That pin is shared with the red rotary encoder LED, which is left unused so it
+ * doesn't hold the line low (see board.h). The LED still flickers while a frame is being sent, and
+ * the line idles high, which is the LED's off state.
+ *
+ * Each frame is
+ *      0xA5 | type | payload (length depends on type) | checksum
+ * where the checksum is the 8-bit sum of the type and payload bytes. Multi-byte values are little endian.
+ * See telemetry_decode.py for a host-side decoder.
+ */
+#define TELEMETRY_BAUD 19200
+#define TELEMETRY_PORT PORTB
+#define TELEMETRY_PIN (1 << 1)
+#define TELEMETRY_SYNC 0xA5
+#define TELEMETRY_FIFO_SIZE 32      // must be a power of 2
+
+typedef enum{
+    TELEMETRY_STATE = 0x01,         // payload: new trigger mode (u8), tick count (u16)
+    TELEMETRY_TICK = 0x02,          // payload: tick count (u16), sent once a second
+    TELEMETRY_ISR_LATENCY = 0x03,   // payload: ISR id (u8), latency in timer counts (u16)
+    TELEMETRY_BATTERY = 0x04,       // payload: raw ADC (u16), battery bar (u8), charging (u8)
+    TELEMETRY_ENCODER = 0x05,       // payload: encoder pins (u8), step (u8), tick count (u16), TIMER0 count (u8)
+}TelemetryType_e;
+
+#ifdef TELEMETRY
+void telemetry_init(void);
+void telemetry_send(TelemetryType_e type, uint8_t *payload, uint8_t len);
+void telemetry_flush(void);
+
+#define TELEMETRY_INIT() telemetry_init()
+#define TELEMETRY_FLUSH() telemetry_flush()
+#define TELEMETRY_SEND(type, ...) do{ \
+        uint8_t _tlm[] = {__VA_ARGS__}; \
+        telemetry_send(type, _tlm, sizeof(_tlm)); \
+    }while(0)
+#else
+#define TELEMETRY_INIT()
+#define TELEMETRY_FLUSH()
+#define TELEMETRY_SEND(type, ...)
+#endif
+
+#define TELEMETRY_U16(n) (uint8_t)(n), (uint8_t)((n) >> 8)
+
+#endif
@@ -0,0 +1,82 @@
+#!/usr/bin/env python3
+"""
+Camera Shutter Control Project, telemetry decoder
+
+Decodes the binary telemetry stream sent out on PB1 (see telemetry.h) into readable lines.
+The input can be a serial port (requires pyserial) or a file of raw captured bytes, with "-" for stdin.
+
+    ./telemetry_decode.py /dev/ttyUSB0
+    ./telemetry_decode.py capture.bin
+
+This program is free software: you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+"""
+import argparse
+import struct
+import sys
+
+SYNC = 0xA5
+BAUD = 19200
+TICK_HZ = 125
+
+MODES = ["STANDBY", "ARM", "TRIGGERED", "WAITING_FOR_NEXT_PIC", "END", "SCHEDULED"]
+STEPS = ["-", "CW", "CCW"]
+
+# type -> (name, struct format of the payload, formatter)
+FRAMES = {
+    0x01: ("STATE", "<BH", lambda m, t: "mode={} tick={}".format(MODES[m] if m < len(MODES) else m, t)),
+    0x02: ("TICK", "<H", lambda t: "tick={} ({:.2f}s)".format(t, t / TICK_HZ)),
+    0x03: ("ISR_LATENCY", "<BH", lambda i, l: "isr={} latency={}".format(i, l)),
+    0x04: ("BATTERY", "<HBB", lambda adc, bar, chg: "adc={} ({:.3f}V) bar={} charging={}".format(
+        adc, adc * 0.005, bar if bar != 0xFF else "?", bool(chg))),
+    0x05: ("ENCODER", "<BBHB", lambda pins, step, t, cnt: "pins={:02b} step={} time={:.3f}s".format(
+        pins, STEPS[step] if step < len(STEPS) else step, t / TICK_HZ + cnt * 32e-6)),
+}
+
+
+def open_input(name):
+    if name == "-":
+        return sys.stdin.buffer
+    if name.startswith("/dev/") or name.upper().startswith("COM"):
+        import serial
+        return serial.Serial(name, BAUD)
+    return open(name, "rb")
+
+
+def frames(stream):
+    """Yields (type, payload) tuples, re-synchronizing on bad checksums"""
+    while True:
+        b = stream.read(1)
+        if not b:
+            return
+        if b[0] != SYNC:
+            continue
+        t = stream.read(1)
+        if not t:
+            return
+        t = t[0]
+        if t not in FRAMES:
+            continue
+        size = struct.calcsize(FRAMES[t][1])
+        data = stream.read(size + 1)
+        if len(data) != size + 1:
+            return
+        if (t + sum(data[:-1])) & 0xFF != data[-1]:
+            print("checksum error", file=sys.stderr)
+            continue
+        yield t, data[:-1]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.strip().splitlines()[0])
+    parser.add_argument("input", help="serial port, capture file, or - for stdin")
+    args = parser.parse_args()
+
+    for t, payload in frames(open_input(args.input)):
+        name, fmt, formatter = FRAMES[t]
+        print("{:12s} {}".format(name, formatter(*struct.unpack(fmt, payload))), flush=True)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,317 @@
+/**
+ * Camera Shutter Control Project, rotary encoder input tests
+ * By Electro707, 2023
+ *
+ * Feeds pin-level encoder traces through encoder.c the way the firmware does, with a model of the pin
+ * change ISR and the main loop around it:
+ *  - the ISR samples the pins 75us after the pin change that started it, and the flag of any change
+ *    while it runs gets cleared at its end
+ *  - while a step is waiting for the main loop, the ISR drops every sample
+ *  - the main loop wakes up to take the step, then spends a while redrawing the field it changed
+ *
+ * Random traces are generated for a few kinds of turning: clean detents, fast spins, contact bounce,
+ * and both pins changing at almost the same time so the ISR misses a transition. For each, the steps
+ * the main loop got are compared against the detents that were turned, and the step accuracy and worst
+ * latency from a detent to the main loop taking its step are listed. Clean turning has to be exact,
+ * the others have to stay above the accuracy the decoding gets now.
+ *
+ * Traces recorded with the telemetry stream (the ENCODER lines of telemetry_decode.py) can be replayed
+ * as well, which checks that encoder_decode() still decodes each recorded sample to the step it did.
+ * test/encoder_snapshot.txt isn't one of those, it's a snapshot written with --record, so replaying it
+ * only catches changes to what the decoder does, not whether it handles real input right.
+ *
+ *     build/test/encoder_test [trace.txt...]
+ *     build/test/encoder_test --record trace.txt      (writes a snapshot from a random bouncy trace)
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "encoder.h"
+
+#define MAX_EDGES 200000
+#define MAX_DETENTS 20000
+
+/* Timing of the firmware, in us */
+#define SAMPLE_DELAY 75         // _delay_loop_2(150) in the ISR, at 4 cycles a loop and 8MHz
+#define ISR_TAIL 5              // from the sample to the ISR clearing the pin change flag
+#define ISR_DROP 2              // ISR run that drops the sample, as a step is still waiting
+#define WAKE_UP 30              // from the ISR to task_input() taking the step
+#define REDRAW 2500             // the main loop redrawing a field, about 100 bytes at 400kHz
+
+/**
+ * A change of the encoder pins, at a time in us
+ */
+typedef struct{
+    uint32_t t;
+    uint8_t pins;
+}Edge_s;
+
+/**
+ * A detent being reached, when the pins settle on it
+ */
+typedef struct{
+    uint32_t t;
+    RotaryEncoderRotation_e dir;
+}Detent_s;
+
+/**
+ * The kinds of turning that get generated, and the step accuracy they have to keep in percent
+ */
+typedef struct{
+    const char *name;
+    uint32_t min_period;    // time per detent, in us
+    uint32_t max_period;
+    uint8_t bounce;         // chance of a transition bouncing, in percent
+    uint8_t missed;         // chance of a detent's two transitions being within the ISR's sample delay
+    uint8_t min_accuracy;
+}TraceKind_s;
+
+static const TraceKind_s kinds[] = {
+    {"clean", 8000, 50000, 0, 0, 100},
+    {"fast", 1000, 8000, 0, 0, 95},
+    {"bounce", 8000, 50000, 30, 0, 60},
+    {"missed", 8000, 50000, 0, 10, 85},
+};
+
+static Edge_s edges[MAX_EDGES];
+static uint32_t n_edges;
+static Detent_s detents[MAX_DETENTS];
+static uint32_t n_detents;
+static uint32_t rng_state = 1;
+static uint8_t failures;
+
+// the quadrature states in clockwise order, the detents are on 00 and 11
+static const uint8_t quadrature[4] = {0b00, 0b01, 0b11, 0b10};
+
+static const char *step_names[] = {"-", "CW", "CCW"};
+
+static uint32_t rng(void){
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static uint32_t rng_range(uint32_t min, uint32_t max){
+    return min + rng() % (max - min + 1);
+}
+
+static void add_edge(uint32_t t, uint8_t pins){
+    if(n_edges == MAX_EDGES){
+        printf("FAIL: trace too long for the test\n");
+        exit(1);
+    }
+    edges[n_edges].t = t;
+    edges[n_edges].pins = pins;
+    n_edges++;
+}
+
+/**
+ * Adds a transition of the pins at time t, with contact bounce if it happens. Returns when the pins
+ * settled
+ */
+static uint32_t add_transition(uint32_t t, uint8_t from, uint8_t to, uint8_t bounce){
+    if(rng() % 100 < bounce){
+        for(uint8_t i=rng_range(1, 3);i>0;i--){
+            add_edge(t, to);
+            t += rng_range(5, 200);
+            add_edge(t, from);
+            t += rng_range(5, 200);
+        }
+    }
+    add_edge(t, to);
+    return t;
+}
+
+/**
+ * Generates a trace of turning the encoder n detents, with the times the detents were reached
+ */
+static void generate(const TraceKind_s *kind, uint32_t n){
+    uint32_t t = 10000, period, first, second;
+    uint8_t pos = 0;
+    int8_t dir = 1;
+
+    n_edges = 0;
+    n_detents = 0;
+    for(uint32_t i=0;i<n;i++){
+        if(rng() % 16 == 0){
+            dir = -dir;
+        }
+        period = rng_range(kind->min_period, kind->max_period);
+        first = t + period / 4;
+        second = t + period * 3 / 4;
+        if(rng() % 100 < kind->missed){
+            second = first + rng_range(5, SAMPLE_DELAY - 10);
+        }
+
+        uint8_t from = quadrature[pos];
+        pos = (pos + dir) & 3;
+        first = add_transition(first, from, quadrature[pos], kind->bounce);
+        from = quadrature[pos];
+        pos = (pos + dir) & 3;
+        if(second <= first){
+            second = first + 1;
+        }
+        second = add_transition(second, from, quadrature[pos], kind->bounce);
+
+        detents[n_detents].t = second;
+        detents[n_detents].dir = (dir > 0) ? ROTARY_ENCODER_ROT_CW : ROTARY_ENCODER_ROT_CCW;
+        n_detents++;
+        t += period;
+    }
+}
+
+/**
+ * Runs a trace through the ISR and main loop model. Returns the step accuracy in percent, with the
+ * worst latency in us from reaching a detent to the main loop taking the first step for it. Extra
+ * steps from bounce don't count towards the latency
+ *
+ * If record isn't NULL, every sample the ISR takes is written to it as telemetry_decode.py would show it
+ */
+static uint32_t simulate(uint32_t *worst_latency, FILE *record){
+    RotaryEncoderRotation_e pending = ROTARY_ENCODER_ROT_NOTHING;
+    uint32_t steps[3] = {0, 0, 0}, turned[3] = {0, 0, 0};
+    uint32_t isr_end = 0, take = 0, busy_until = 0, sample_t;
+    uint32_t detent = 0, wrong = 0;
+    bool served = true;         // the last detent reached got its step
+    uint8_t pvcv = 0, pins;
+
+    *worst_latency = 0;
+    for(uint32_t i=0;i<=n_edges;i++){
+        uint32_t t = (i < n_edges) ? edges[i].t : UINT32_MAX;
+
+        // the main loop takes the step once it gets to it
+        if(pending != ROTARY_ENCODER_ROT_NOTHING && take <= t){
+            steps[pending]++;
+            if(!served && pending == detents[detent-1].dir){
+                served = true;
+                if(take - detents[detent-1].t > *worst_latency){
+                    *worst_latency = take - detents[detent-1].t;
+                }
+            }
+            pending = ROTARY_ENCODER_ROT_NOTHING;
+            busy_until = take + REDRAW;
+        }
+        if(i == n_edges){
+            break;
+        }
+        if(t < isr_end){
+            // the flag of this change gets cleared by the running ISR
+            continue;
+        }
+        if(pending != ROTARY_ENCODER_ROT_NOTHING){
+            isr_end = t + ISR_DROP;
+            continue;
+        }
+
+        sample_t = t + SAMPLE_DELAY;
+        pins = edges[i].pins;
+        for(uint32_t j=i+1;j<n_edges && edges[j].t <= sample_t;j++){
+            pins = edges[j].pins;
+        }
+        isr_end = sample_t + ISR_TAIL;
+        while(detent < n_detents && detents[detent].t <= sample_t){
+            detent++;
+            served = false;
+        }
+
+        pending = encoder_decode(&pvcv, pins);
+        if(record){
+            fprintf(record, "ENCODER      pins=%u%u step=%s time=%.3fs\n", (pins >> 1) & 1, pins & 1,
+                    step_names[pending], sample_t / 1e6);
+        }
+        if(pending != ROTARY_ENCODER_ROT_NOTHING){
+            take = ((isr_end > busy_until) ? isr_end : busy_until) + WAKE_UP;
+        }
+    }
+
+    for(uint32_t i=0;i<n_detents;i++){
+        turned[detents[i].dir]++;
+    }
+    for(uint8_t d=ROTARY_ENCODER_ROT_CW;d<=ROTARY_ENCODER_ROT_CCW;d++){
+        wrong += (steps[d] > turned[d]) ? steps[d] - turned[d] : turned[d] - steps[d];
+    }
+    return (wrong >= n_detents) ? 0 : 100 - (wrong * 100 + n_detents - 1) / n_detents;
+}
+
+/**
+ * Replays the samples of a recorded trace, checking each decodes to the step that was recorded
+ */
+static void replay(const char *name){
+    FILE *f = fopen(name, "r");
+    char line[128], pins_text[3], step_text[4];
+    uint32_t samples = 0, steps = 0, differ = 0;
+    RotaryEncoderRotation_e step, recorded;
+    uint8_t pvcv = 0;
+    double t;
+
+    if(!f){
+        perror(name);
+        exit(1);
+    }
+    while(fgets(line, sizeof(line), f)){
+        if(sscanf(line, "ENCODER pins=%2[01] step=%3s time=%lf", pins_text, step_text, &t) != 3){
+            continue;
+        }
+        for(recorded=ROTARY_ENCODER_ROT_NOTHING;recorded<=ROTARY_ENCODER_ROT_CCW;recorded++){
+            if(strcmp(step_text, step_names[recorded]) == 0){
+                break;
+            }
+        }
+        step = encoder_decode(&pvcv, (uint8_t)strtoul(pins_text, NULL, 2));
+        samples++;
+        steps += (recorded != ROTARY_ENCODER_ROT_NOTHING);
+        if(step != recorded){
+            if(differ == 0){
+                printf("%s: sample at %.3fs decoded to %s instead of %s\n", name, t, step_names[step], step_text);
+            }
+            differ++;
+        }
+    }
+    fclose(f);
+    printf("%-8s %6u samples, %5u steps, %u differ  %s\n", "replay", samples, steps, differ, differ ? "FAIL" : "OK");
+    failures += (differ != 0);
+}
+
+int main(int argc, char **argv){
+    uint32_t accuracy, latency;
+    FILE *record;
+
+    if(argc == 3 && strcmp(argv[1], "--record") == 0){
+        record = fopen(argv[2], "w");
+        if(!record){
+            perror(argv[2]);
+            return 1;
+        }
+        fprintf(record, "# regression snapshot, not a hardware capture: generated by encoder_test --record from a random trace\n"
+                        "# with contact bounce, so the steps are the ones encoder_decode() gave when it was made\n");
+        generate(&kinds[2], 200);
+        simulate(&latency, record);
+        fclose(record);
+        return 0;
+    }
+
+    for(uint8_t k=0;k<sizeof(kinds)/sizeof(kinds[0]);k++){
+        generate(&kinds[k], MAX_DETENTS);
+        accuracy = simulate(&latency, NULL);
+        printf("%-8s %6u detents, %3u%% accurate, worst latency %5.2fms  %s\n", kinds[k].name, n_detents,
+               accuracy, latency / 1000.0, (accuracy < kinds[k].min_accuracy) ? "FAIL" : "OK");
+        failures += (accuracy < kinds[k].min_accuracy);
+    }
+    for(int i=1;i<argc;i++){
+        replay(argv[i]);
+    }
+
+    if(failures){
+        printf("%u encoder checks FAILED\n", failures);
+        return 1;
+    }
+    return 0;
+}
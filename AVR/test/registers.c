@@ -0,0 +1,15 @@
+/**
+ * Camera Shutter Control Project, host I/O registers
+ * By Electro707, 2023
+ *
+ * Defines the registers declared by the stand-in <avr/io.h>
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+
+#define AVR_REGISTER_DEFINE(name) volatile uint8_t name;
+AVR_REGISTERS(AVR_REGISTER_DEFINE)
@@ -0,0 +1,409 @@
+/**
+ * Camera Shutter Control Project, display rendering tests
+ * By Electro707, 2023
+ *
+ * Draws the screens with oled.c, menu.c, progress.c and trim.c, with the I2C bus feeding a model of the
+ * SSD1306's RAM and addressing instead of a display. Each screen is compared against its golden image in
+ * test/golden, and the bytes sent to draw it are listed (for the progress view, the average sent by each
+ * second's update). A screen that doesn't match gets written to the output folder to be looked at.
+ *
+ * The images are plain PBMs, where 1 is a lit pixel, so they can be viewed with most image viewers and
+ * diffed as text.
+ *
+ *     build/test/screen_test test/golden build/test
+ *     build/test/screen_test test/golden build/test --update     (rewrites the golden images)
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "oled.h"
+#include "menu.h"
+#include "progress.h"
+#include "trim.h"
+#include "trigger.h"
+#include "layout.h"
+#include "fields.h"
+
+#define WIDTH 128
+#define LINES 8
+
+typedef uint8_t Screen_t[LINES][WIDTH];
+
+typedef enum{
+    BUS_IDLE = 0,
+    BUS_CONTROL,        // started, waiting for the control byte
+    BUS_COMMAND,
+    BUS_DATA,
+}BusState_e;
+
+/* The display model */
+static Screen_t ram;
+static uint8_t col_start, col_end = WIDTH-1, line_start, line_end = LINES-1;
+static uint8_t col, line;
+static BusState_e bus;
+static uint8_t command[3];
+static uint8_t command_len;
+static uint32_t tx_bytes;
+
+static const char *golden_folder, *out_folder;
+static bool update;
+static uint8_t failures;
+
+TriggerChannel_s channels[TRIGGER_N_CHANNELS];         // the field tables in fields.c point into these
+
+static void fail(const char *what){
+    printf("FAIL: %s\n", what);
+    exit(1);
+}
+
+/**
+ * Returns how many argument bytes follow a command, for the commands the firmware sends
+ */
+static uint8_t command_args(uint8_t c){
+    switch(c){
+        case 0x21:      // column address
+        case 0x22:      // page address
+            return 2;
+        case 0x20:      // addressing mode
+        case 0x81:
+        case 0x8D:
+        case 0xA8:
+        case 0xD3:
+        case 0xD5:
+        case 0xD9:
+        case 0xDA:
+        case 0xDB:
+            return 1;
+        default:
+            return 0;
+    }
+}
+
+static void ssd1306_command(uint8_t c){
+    command[command_len++] = c;
+    if(command_len <= command_args(command[0])){
+        return;
+    }
+    command_len = 0;
+    switch(command[0]){
+        case 0x20:
+            if(command[1] != 0x00){
+                fail("only horizontal addressing is modelled");
+            }
+            break;
+        case 0x21:
+            col_start = command[1] & 0x7F;
+            col_end = command[2] & 0x7F;
+            col = col_start;
+            break;
+        case 0x22:
+            line_start = command[1] & 0x07;
+            line_end = command[2] & 0x07;
+            line = line_start;
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * Writes a byte of display data, wrapping around within the area set with the address commands
+ */
+static void ssd1306_data(uint8_t data){
+    ram[line][col] = data;
+    if(col++ == col_end){
+        col = col_start;
+        if(line++ == line_end){
+            line = line_start;
+        }
+    }
+}
+
+unsigned char USI_TWI_Start_Write(unsigned char address){
+    tx_bytes++;
+    if(bus != BUS_IDLE){
+        fail("transaction started twice");
+    }
+    if(address != (OLED_SLAVE_ADDR << 1)){
+        fail("wrong address");
+    }
+    bus = BUS_CONTROL;
+    return 1;
+}
+
+unsigned char USI_TWI_Write_Byte(unsigned char data){
+    tx_bytes++;
+    switch(bus){
+        case BUS_IDLE:
+            fail("byte sent outside of a transaction");
+            break;
+        case BUS_CONTROL:
+            if(data == OLED_CONTROL_COMMAND){
+                bus = BUS_COMMAND;
+            } else if(data == OLED_CONTROL_DATA){
+                bus = BUS_DATA;
+            } else {
+                fail("unknown control byte");
+            }
+            break;
+        case BUS_COMMAND:
+            ssd1306_command(data);
+            break;
+        case BUS_DATA:
+            ssd1306_data(data);
+            break;
+    }
+    return 1;
+}
+
+unsigned char USI_TWI_Master_Stop(void){
+    if(bus == BUS_IDLE){
+        fail("stop outside of a transaction");
+    }
+    if(command_len != 0){
+        fail("command cut short");
+    }
+    bus = BUS_IDLE;
+    return 1;
+}
+
+unsigned char USI_TWI_Bus_Recover(void){
+    return 1;
+}
+
+static void write_pbm(const char *name, Screen_t screen){
+    FILE *f = fopen(name, "w");
+
+    if(!f){
+        perror(name);
+        exit(1);
+    }
+    fprintf(f, "P1\n%u %u\n", WIDTH, LINES*8);
+    for(uint8_t y=0;y<LINES*8;y++){
+        for(uint8_t x=0;x<WIDTH;x++){
+            fputc((screen[y/8][x] & (1 << (y%8))) ? '1' : '0', f);
+        }
+        fputc('\n', f);
+    }
+    fclose(f);
+}
+
+/**
+ * Reads an image written by write_pbm(), returns false if there isn't one
+ */
+static bool read_pbm(const char *name, Screen_t screen){
+    FILE *f = fopen(name, "r");
+    unsigned width, height;
+    int c;
+
+    if(!f){
+        return false;
+    }
+    if(fscanf(f, "P1 %u %u", &width, &height) != 2 || width != WIDTH || height != LINES*8){
+        fail("golden image isn't a 128x64 plain PBM");
+    }
+    memset(screen, 0, sizeof(Screen_t));
+    for(uint16_t i=0;i<WIDTH*LINES*8;){
+        c = fgetc(f);
+        if(c == EOF){
+            fail("golden image cut short");
+        }
+        if(c == '1'){
+            screen[i/WIDTH/8][i%WIDTH] |= 1 << ((i/WIDTH)%8);
+        }
+        if(c == '0' || c == '1'){
+            i++;
+        }
+    }
+    fclose(f);
+    return true;
+}
+
+/**
+ * Compares what's on the display against a golden image, with the bytes sent since the last check
+ */
+static void check_screen(const char *name){
+    char path[256];
+    Screen_t golden;
+
+    printf("%-16s %5u bytes", name, tx_bytes);
+    tx_bytes = 0;
+
+    snprintf(path, sizeof(path), "%s/%s.pbm", golden_folder, name);
+    if(update){
+        write_pbm(path, ram);
+        printf("  updated\n");
+        return;
+    }
+    if(!read_pbm(path, golden)){
+        printf("  FAIL: no golden image\n");
+        failures++;
+        return;
+    }
+    if(memcmp(golden, ram, sizeof(ram)) != 0){
+        snprintf(path, sizeof(path), "%s/%s.pbm", out_folder, name);
+        write_pbm(path, ram);
+        printf("  FAIL: doesn't match, see %s\n", path);
+        failures++;
+        return;
+    }
+    printf("  OK\n");
+}
+
+/**
+ * Checks that the screen is the same as one that was saved, for screens drawn two ways
+ */
+static void check_same(const Screen_t expected, const char *what){
+    if(memcmp(expected, ram, sizeof(ram)) != 0){
+        printf("FAIL: %s\n", what);
+        failures++;
+    }
+}
+
+/**
+ * Starts from a display with noise in its RAM, the way it powers up
+ */
+static void power_up(void){
+    for(uint16_t i=0;i<sizeof(ram);i++){
+        ram[i/WIDTH][i%WIDTH] = (uint8_t)(i * 0x9E37 >> 8);
+    }
+    oled_init();
+    oled_clear_display();
+    oled_display_on(true);
+    tx_bytes = 0;
+}
+
+/**
+ * The settings screens, drawn the same way as draw_main_screen() in main.c
+ */
+static void test_settings(void){
+    Screen_t from_layout;
+
+    memset(channels, 0, sizeof(channels));
+    channels[0].cur.trt = 10;
+    channels[0].cur.tt = 5;
+    channels[0].cur.n_pic = 120;
+    channels[0].cur.tmlps_interv = 90;
+    channels[0].cur.start_delay = 3600;
+    channels[0].cur.window = 7200;
+    channels[1].cur.trt = 2;
+    channels[1].cur.n_pic = 3;
+    channels[1].cur.tmlps_interv = 45;
+
+    power_up();
+    menu_init(menu_fields, sizeof(menu_fields)/sizeof(MenuField_s));
+    oled_send_layout(main_layout);
+    menu_invalidate(MENU_ALL_FIELDS);
+    menu_draw();
+    check_screen("settings");
+    memcpy(from_layout, ram, sizeof(ram));
+
+    // the pre-rendered layout has to look the same as drawing the labels
+    power_up();
+    menu_draw_labels();
+    menu_invalidate(MENU_ALL_FIELDS);
+    menu_draw();
+    tx_bytes = 0;
+    check_same(from_layout, "the layout image doesn't match the labels drawn by menu_draw_labels()");
+
+    // editing a digit only redraws its field
+    menu_next_field();
+    menu_next_digit();
+    menu_change(1);
+    menu_draw();
+    check_screen("settings_edit");
+
+    menu_init(channel2_fields, sizeof(channel2_fields)/sizeof(MenuField_s));
+    oled_clear_display();
+    menu_draw_labels();
+    oled_send_text_P(PSTR("Channel 2"), 7);
+    menu_invalidate(MENU_ALL_FIELDS);
+    menu_draw();
+    check_screen("channel2");
+}
+
+/**
+ * The clock trim page, drawn the same way as draw_trim_page() in main.c
+ */
+static void test_trim(void){
+    power_up();
+    trim_ppm = -1234;
+    menu_init(trim_fields, sizeof(trim_fields)/sizeof(MenuField_s));
+    trim_draw_page();
+    menu_draw_labels();
+    menu_invalidate(MENU_ALL_FIELDS);
+    menu_draw();
+    check_screen("trim");
+}
+
+/**
+ * The progress view, drawn over the settings screen and updated every second the way the timer ISR and
+ * task_sequence() do. Drawing it again all at once has to give the same screen
+ */
+static void test_progress(void){
+    Screen_t updated;
+    TriggerChannel_s first;
+    uint32_t updates = 0;
+
+    power_up();
+    menu_init(menu_fields, sizeof(menu_fields)/sizeof(MenuField_s));
+    oled_send_layout(main_layout);
+    menu_invalidate(MENU_ALL_FIELDS);
+    menu_draw();
+    tx_bytes = 0;
+
+    memset(channels, 0, sizeof(channels));
+    channels[0].mode = TRIGGER_MODE_ARM;
+    channels[0].old.tt = 2;
+    channels[0].old.trt = 1;
+    channels[0].old.n_pic = 9;
+    channels[0].old.tmlps_interv = 10;
+    progress_start(channels);
+    progress_draw();
+    check_screen("progress_start");
+
+    // a picture ends every 10 seconds
+    memset(&first, 0, sizeof(first));
+    first.mode = TRIGGER_MODE_WAITING_FOR_NEXT_PIC;
+    for(uint8_t s=1;s<=37;s++){
+        first.cur.n_pic = 9 - s/10;
+        progress_step((s % 10 == 2) ? TRIGGER_MODE_TRIGGERED : TRIGGER_MODE_WAITING_FOR_NEXT_PIC,
+                      (s % 10 == 2) ? first.cur.n_pic + 1 : first.cur.n_pic, &first);
+        progress_draw();
+        updates += tx_bytes;
+        tx_bytes = 0;
+    }
+    tx_bytes = updates / 37;
+    check_screen("progress");
+    memcpy(updated, ram, sizeof(ram));
+
+    progress_invalidate();
+    progress_draw();
+    tx_bytes = 0;
+    check_same(updated, "updating the progress view every second doesn't match drawing it all at once");
+}
+
+int main(int argc, char **argv){
+    if(argc < 3){
+        printf("usage: %s <golden folder> <output folder> [--update]\n", argv[0]);
+        return 1;
+    }
+    golden_folder = argv[1];
+    out_folder = argv[2];
+    update = argc > 3 && strcmp(argv[3], "--update") == 0;
+
+    test_settings();
+    test_trim();
+    test_progress();
+
+    if(failures){
+        printf("%u screens FAILED\n", failures);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,27 @@
+/**
+ * Camera Shutter Control Project, host stand-in for <avr/eeprom.h>
+ * By Electro707, 2023
+ *
+ * EEMEM variables are plain variables on the host, which start out as zeros.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef STUB_AVR_EEPROM_H
+#define STUB_AVR_EEPROM_H
+
+#include <string.h>
+
+#define EEMEM
+
+static inline void eeprom_read_block(void *dst, const void *src, size_t n){
+    memcpy(dst, src, n);
+}
+
+static inline void eeprom_update_block(const void *src, void *dst, size_t n){
+    memcpy(dst, src, n);
+}
+
+#endif
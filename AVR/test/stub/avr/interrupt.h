@@ -0,0 +1,20 @@
+/**
+ * Camera Shutter Control Project, host stand-in for <avr/interrupt.h>
+ * By Electro707, 2023
+ *
+ * The tests call the ISRs themselves, so an ISR is a plain function and enabling or disabling
+ * interrupts does nothing.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef STUB_AVR_INTERRUPT_H
+#define STUB_AVR_INTERRUPT_H
+
+#define ISR(vector) void vector(void)
+#define cli()
+#define sei()
+
+#endif
@@ -0,0 +1,60 @@
+/**
+ * Camera Shutter Control Project, host stand-in for <avr/io.h>
+ * By Electro707, 2023
+ *
+ * The I/O registers are plain variables on the host, defined in registers.c, so the tests can set the
+ * inputs and read back what the firmware drove. Only the registers and bits the tested modules use
+ * are here.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef STUB_AVR_IO_H
+#define STUB_AVR_IO_H
+
+#include <stdint.h>
+
+#define AVR_REGISTERS(R) \
+    R(PORTA) R(PORTB) R(PINA) R(PINB) R(DDRA) R(DDRB) \
+    R(TCCR0A) R(TCCR0B) R(TCNT0L) R(TCNT0H) R(OCR0A) R(TIMSK) R(TIFR) R(GTCCR) \
+    R(TCCR1A) R(TCCR1B) R(TC1H) R(TCNT1) R(OCR1C) \
+    R(GIMSK) R(GIFR) R(PCMSK0) R(PCMSK1) \
+    R(USIDR) R(USICR) R(USISR) \
+    R(CLKPR) R(SREG) R(MCUSR) R(WDTCR) R(OSCCAL)
+
+#define AVR_REGISTER_DECLARE(name) extern volatile uint8_t name;
+AVR_REGISTERS(AVR_REGISTER_DECLARE)
+
+#define OCIE0A 4
+#define OCF0A 4
+#define PSR0 0
+#define TOV1 2
+#define TOIE1 2
+#define PCIE0 4
+#define PCIE1 5
+#define PCIF 5
+#define PCINT6 6
+#define PCINT7 7
+#define PCINT9 1
+#define USISIE 7
+#define USIOIE 6
+#define USIWM1 5
+#define USIWM0 4
+#define USICS1 3
+#define USICS0 2
+#define USICLK 1
+#define USITC 0
+#define USISIF 7
+#define USIOIF 6
+#define USIPF 5
+#define USIDC 4
+#define USICNT0 0
+#define PORTB0 0
+#define PORTB2 2
+#define PINB0 0
+#define PINB2 2
+#define CLKPCE 7
+
+#endif
@@ -0,0 +1,18 @@
+/**
+ * Camera Shutter Control Project, host stand-in for <util/delay.h>
+ * By Electro707, 2023
+ *
+ * Nothing the tests build waits on the hardware, so there are no delays.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef STUB_UTIL_DELAY_H
+#define STUB_UTIL_DELAY_H
+
+#define _delay_us(us) ((void)(us))
+#define _delay_ms(ms) ((void)(ms))
+
+#endif
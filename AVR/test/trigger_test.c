@@ -0,0 +1,340 @@
+/**
+ * Camera Shutter Control Project, trigger state machine tests
+ * By Electro707, 2023
+ *
+ * Arms trigger.c with random settings, steps it a second at a time, and checks the edges it drives on
+ * PA0 and PA1 against the times worked out from the settings:
+ *  - a picture starts every interval, the first one included
+ *  - the shutter line gets pressed max(tt, 1) seconds into a picture, and held for trt seconds
+ *  - arming only accepts an interval of at least trt + max(tt, 1) when there is more than one picture
+ *  - a second channel with a shutter time of 0 follows the first, otherwise it runs its own sequence
+ *  - pictures only start within the daily window, and a picture in progress always gets finished
+ *  - the settings are restored once the sequence ends
+ *
+ * Built with FLASH_SYNC, the flash-sync is stood in for by a camera that misses the pictures it's told
+ * to, to check the retries and waits of the adaptive interval.
+ *
+ *     build/test/trigger_test [seed]
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "board.h"
+#include "trigger.h"
+#include "flashsync.h"
+
+#define N_SEQUENCES 20000           // sequences without a window
+#define N_WINDOW_SEQUENCES 100      // sequences with a start delay and window, which take days each
+#define MAX_SHOTS 64
+
+/**
+ * The times a shutter line was pressed and released, in seconds after arming
+ */
+typedef struct{
+    int32_t on[MAX_SHOTS];
+    int32_t off[MAX_SHOTS];
+    uint8_t n;
+}Shots_s;
+
+static uint32_t seed;
+static uint32_t rng_state;
+static uint32_t sequence;
+static TriggerChannel_s channels[TRIGGER_N_CHANNELS];
+static ShutterTriggerVars_s settings[TRIGGER_N_CHANNELS];
+
+static uint32_t rng(void){
+    // xorshift32
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+static int32_t rng_range(int32_t min, int32_t max){
+    return min + (int32_t)(rng() % (uint32_t)(max - min + 1));
+}
+
+#ifdef FLASH_SYNC
+/* The stand-in camera, which misses the pictures marked here and asks for the waits after them */
+static bool camera_miss[MAX_SHOTS];
+static int32_t camera_wait[MAX_SHOTS];
+static uint8_t camera_shot;
+
+void flashsync_start(void){
+    camera_shot = 0;
+}
+
+void flashsync_arm(void){
+}
+
+bool flashsync_missed(int32_t *interval){
+    uint8_t shot = camera_shot++;
+
+    *interval = camera_wait[shot];
+    return camera_miss[shot];
+}
+#endif
+
+static void fail(const char *what){
+    printf("FAIL: %s\n", what);
+    printf("seed %u, sequence %u\n", seed, sequence);
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        printf("channel %u: tt %d trt %d n_pic %d interv %d start %d window %d\n", i, settings[i].tt,
+               settings[i].trt, settings[i].n_pic, settings[i].tmlps_interv, settings[i].start_delay,
+               settings[i].window);
+    }
+    exit(1);
+}
+
+/**
+ * Returns if second t after arming is in an active window
+ */
+static bool in_window(const ShutterTriggerVars_s *s, int32_t t){
+    if(t <= s->start_delay){
+        return false;
+    }
+    return s->window == 0 || ((t - s->start_delay - 1) % TRIGGER_WINDOW_PERIOD) < s->window;
+}
+
+/**
+ * Returns the first second from t on that is in an active window
+ */
+static int32_t next_window(const ShutterTriggerVars_s *s, int32_t t){
+    int32_t into;
+
+    if(t <= s->start_delay){
+        return s->start_delay + 1;
+    }
+    if(s->window == 0){
+        return t;
+    }
+    into = (t - s->start_delay - 1) % TRIGGER_WINDOW_PERIOD;
+    return (into < s->window) ? t : t + TRIGGER_WINDOW_PERIOD - into;
+}
+
+/**
+ * Works out the shots a channel takes with the settings s, returns the second it goes back to standby.
+ * The adaptive interval only applies to the first channel
+ */
+static int32_t expected_shots(const ShutterTriggerVars_s *s, bool adaptive, Shots_s *shots){
+    int32_t start = next_window(s, 1);
+    int32_t left = s->n_pic;
+    int32_t on, off, wait, next;
+#ifdef FLASH_SYNC
+    uint8_t attempt = 0;
+#endif
+    bool retry = false;
+
+    shots->n = 0;
+    for(;;){
+        on = start + (s->tt ? s->tt : 1) - 1;
+        off = on + s->trt;
+        if(shots->n == MAX_SHOTS){
+            fail("too many shots for the test");
+        }
+        shots->on[shots->n] = on;
+        shots->off[shots->n] = off;
+        shots->n++;
+
+        // the interval counts from the start of the picture, what's left of it is waited out after
+        // the shutter line gets released
+        wait = start + s->tmlps_interv - (off + 1);
+#ifdef FLASH_SYNC
+        if(adaptive){
+            retry = camera_miss[attempt];
+            wait = camera_wait[attempt];
+            attempt++;
+        }
+#endif
+        if(!retry){
+            if(left == 0){
+                return off + 1;
+            }
+            left--;
+        }
+        if(wait < 0){
+            wait = 0;
+        }
+        next = off + 1 + wait;
+        // a window closing while waiting drops the rest of the wait until the next one opens
+        for(int32_t t=off+1;t<=next;t++){
+            if(!in_window(s, t)){
+                next = next_window(s, t);
+                break;
+            }
+        }
+        start = next;
+    }
+}
+
+static void compare_shots(const Shots_s *expected, const Shots_s *got, uint8_t line){
+    char what[80];
+
+    if(expected->n != got->n){
+        snprintf(what, sizeof(what), "PA%u took %u shots instead of %u", line, got->n, expected->n);
+        fail(what);
+    }
+    for(uint8_t i=0;i<expected->n;i++){
+        if(expected->on[i] != got->on[i] || expected->off[i] != got->off[i]){
+            snprintf(what, sizeof(what), "PA%u shot %u was %d-%d instead of %d-%d", line, i,
+                     got->on[i], got->off[i], expected->on[i], expected->off[i]);
+            fail(what);
+        }
+    }
+}
+
+/**
+ * Records the edges on a shutter line
+ */
+static void record_edge(Shots_s *shots, uint8_t prev, uint8_t now, uint8_t pin, int32_t t){
+    if(!(prev & pin) && (now & pin)){
+        if(shots->n == MAX_SHOTS){
+            fail("too many shots");
+        }
+        shots->on[shots->n] = t;
+    } else if((prev & pin) && !(now & pin)){
+        shots->off[shots->n] = t;
+        shots->n++;
+    }
+}
+
+static bool settings_valid(const ShutterTriggerVars_s *s){
+    return s->n_pic == 0 || FLASHSYNC_ADAPTIVE(s->tmlps_interv)
+           || s->tmlps_interv >= s->trt + (s->tt ? s->tt : 1);
+}
+
+/**
+ * Arms and runs a sequence with the settings, returns how many shots were taken
+ */
+static uint32_t run_sequence(void){
+    ShutterTriggerVars_s armed[TRIGGER_N_CHANNELS];
+    Shots_s expected[TRIGGER_N_CHANNELS], got[TRIGGER_N_CHANNELS];
+    bool follow = settings[1].trt == 0;
+    int32_t end[TRIGGER_N_CHANNELS];
+    int32_t t = 0, last = 0;
+    TriggerMode_e mode;
+    uint8_t prev;
+
+    memset(channels, 0, sizeof(channels));
+    memset(got, 0, sizeof(got));
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        channels[i].cur = settings[i];
+    }
+    PORTA = 0;
+    PORTB = 0;
+
+    mode = trigger_arm(channels);
+    if(!settings_valid(&settings[0]) || (!follow && !settings_valid(&settings[1]))){
+        if(mode != TRIGGER_MODE_STANDBY || channels[0].mode != TRIGGER_MODE_STANDBY
+           || channels[1].mode != TRIGGER_MODE_STANDBY){
+            fail("armed with invalid settings");
+        }
+        return 0;
+    }
+    if(mode != (settings[0].start_delay ? TRIGGER_MODE_SCHEDULED : TRIGGER_MODE_ARM)){
+        fail("didn't arm with valid settings");
+    }
+
+    // the second channel runs in the start delay and window of the first
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        armed[i] = settings[i];
+        armed[i].start_delay = settings[0].start_delay;
+        armed[i].window = settings[0].window;
+    }
+    end[0] = expected_shots(&armed[0], FLASHSYNC_ADAPTIVE(armed[0].tmlps_interv), &expected[0]);
+    if(follow){
+        expected[1] = expected[0];
+        end[1] = end[0];
+    } else {
+        end[1] = expected_shots(&armed[1], false, &expected[1]);
+    }
+    last = (end[0] > end[1]) ? end[0] : end[1];
+
+    do{
+        prev = PORTA;
+        mode = trigger_step(channels);
+        t++;
+        for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+            record_edge(&got[i], prev, PORTA, TRIGGER_PIN(i), t);
+        }
+        if(t > last){
+            fail("sequence didn't end");
+        }
+    }while(mode != TRIGGER_MODE_STANDBY);
+
+    if(t != last){
+        fail("sequence ended early");
+    }
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        compare_shots(&expected[i], &got[i], i);
+    }
+    if(PORTA & (TRIGGER_PIN(0) | TRIGGER_PIN(1))){
+        fail("shutter line left pressed");
+    }
+    if((PORTB & (LED_RED_PIN | LED_GREEN_PIN | LED_BLUE_PIN)) != (LED_RED_PIN | LED_GREEN_PIN | LED_BLUE_PIN)){
+        fail("LEDs left on");
+    }
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        if(memcmp(&channels[i].cur, &channels[i].old, sizeof(channels[i].cur)) != 0
+           || memcmp(&channels[i].old, &armed[i], sizeof(armed[i])) != 0){
+            fail("settings not restored");
+        }
+    }
+    return expected[0].n + (follow ? 0 : expected[1].n);
+}
+
+static void random_settings(ShutterTriggerVars_s *s, bool second){
+    int32_t min;
+
+    s->trt = (second && rng() % 3 == 0) ? 0 : rng_range(1, 5);
+    s->tt = rng_range(0, 4);
+    s->n_pic = (rng() % 4 == 0) ? 0 : rng_range(1, 6);
+    min = s->trt + (s->tt ? s->tt : 1);
+    switch(rng() % 8){
+        case 0:
+            s->tmlps_interv = 0;                        // adaptive with the flash-sync
+            break;
+        case 1:
+            s->tmlps_interv = rng_range(0, min - 1);    // too short to be armed
+            break;
+        default:
+            s->tmlps_interv = rng_range(min, min + 5);
+            break;
+    }
+    s->start_delay = 0;
+    s->window = 0;
+}
+
+int main(int argc, char **argv){
+    uint32_t armed = 0, shots = 0;
+
+    seed = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1;
+    rng_state = seed ? seed : 1;
+
+    for(sequence=0;sequence<N_SEQUENCES+N_WINDOW_SEQUENCES;sequence++){
+        for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+            random_settings(&settings[i], i != 0);
+        }
+        if(sequence >= N_SEQUENCES){
+            settings[0].start_delay = rng_range(0, 5);
+            settings[0].window = rng_range(1, 30);
+        }
+#ifdef FLASH_SYNC
+        for(uint8_t i=0;i<MAX_SHOTS;i++){
+            // never more misses than pictures, so the shots fit
+            camera_miss[i] = (i < 8) && (rng() % 3 == 0);
+            camera_wait[i] = rng_range(0, 3);
+        }
+#endif
+        uint32_t n = run_sequence();
+        shots += n;
+        armed += (n != 0);
+    }
+    printf("%u sequences, %u armed, %u shots OK\n", sequence, armed, shots);
+    return 0;
+}
@@ -0,0 +1,132 @@
+#!/usr/bin/env python3
+"""
+Camera Shutter Control Project, simulator trace check
+
+Checks the shutter edges on PA0 and PA1 in a trace recorded by simavr against the settings the trace
+build armed with. The times the lines should be pressed and released are worked out from the settings
+the same way trigger.c runs them:
+ - a picture starts every interval, the first one a second after arming
+ - the shutter line gets pressed max(tt, 1) seconds into a picture, and held for trt seconds
+ - n_pic + 1 pictures get taken
+
+The edges are timed from the ARMED line, which the trace build raises right after arming, so the delay
+to the first picture gets checked along with the rest. Exits with an error if the ARMED line never goes
+up, or if an edge is missing, extra, or off by more than the tolerance.
+
+    ./trace_check.py build/trace/trace.vcd simtrace.h
+
+This program is free software: you can redistribute it and/or modify it under the terms of the
+GNU General Public License as published by the Free Software Foundation, either version 3 of the
+License, or (at your option) any later version.
+"""
+import argparse
+import re
+import sys
+
+SHUTTERS = ("SHUTTER_PA0", "SHUTTER_PA1")
+SIGNALS = SHUTTERS + ("ARMED",)
+TIMESCALE_UNITS = {"s": 1, "ms": 1e-3, "us": 1e-6, "ns": 1e-9, "ps": 1e-12, "fs": 1e-15}
+
+
+def read_settings(header):
+    """Returns the settings of each channel as a list of dictionaries, from the SIMTRACE_ defines"""
+    defines = {}
+    with open(header) as f:
+        for line in f:
+            m = re.match(r"#define\s+SIMTRACE_(\w+?)(\d)\s+(-?\d+)", line)
+            if m:
+                defines.setdefault(int(m.group(2)), {})[m.group(1).lower()] = int(m.group(3))
+    return [defines[ch] for ch in sorted(defines)]
+
+
+def expected_edges(s):
+    """Returns the (second, level) edges a channel drives, in seconds after arming"""
+    edges = []
+    start = 1
+    for _ in range(s["npic"] + 1):
+        on = start + max(s["tt"], 1) - 1
+        off = on + s["trt"]
+        edges += [(on, 1), (off, 0)]
+        start += s["interv"]
+    return edges
+
+
+def read_vcd(vcd):
+    """Returns a dictionary of signal name -> list of (seconds, level) changes"""
+    scale = 1e-9
+    ids = {}
+    changes = {name: [] for name in SIGNALS}
+    # all of the lines start out low after a reset, simavr may not list their first value
+    levels = {name: 0 for name in SIGNALS}
+    t = 0
+    with open(vcd) as f:
+        text = f.read()
+    header, _, body = text.partition("$enddefinitions")
+    m = re.search(r"\$timescale\s+(\d+)\s*(\w+)\s+\$end", header)
+    if m:
+        scale = int(m.group(1)) * TIMESCALE_UNITS[m.group(2)]
+    for m in re.finditer(r"\$var\s+\w+\s+\d+\s+(\S+)\s+(\S+)", header):
+        if m.group(2) in SIGNALS:
+            ids[m.group(1)] = m.group(2)
+    for name in SIGNALS:
+        if name not in ids.values():
+            sys.exit(f"{name} isn't in {vcd}")
+    tokens = iter(body.split()[1:])
+    for token in tokens:
+        if token[0] in "bBrR":
+            # a vector value, which is followed by its id. None of the shutter lines are vectors
+            next(tokens, None)
+        elif token.startswith("#"):
+            t = int(token[1:]) * scale
+        elif token[0] in "01xXzZ" and token[1:] in ids:
+            name = ids[token[1:]]
+            level = 1 if token[0] == "1" else 0
+            if levels[name] != level:
+                changes[name].append((t, level))
+            levels[name] = level
+    return changes
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Checks the shutter edges in a simavr trace")
+    parser.add_argument("vcd", help="the trace.vcd simavr recorded")
+    parser.add_argument("header", help="simtrace.h, with the settings the trace build armed with")
+    parser.add_argument("--tolerance", type=float, default=0.001,
+                        help="how far off an edge can be, in seconds (default 1ms)")
+    args = parser.parse_args()
+
+    settings = read_settings(args.header)
+    changes = read_vcd(args.vcd)
+    expected = [expected_edges(s) for s in settings]
+
+    armed = [t for t, level in changes["ARMED"] if level]
+    if not armed:
+        sys.exit("the ARMED line never went up, the sequence didn't get armed")
+    offset = armed[0]
+
+    failed = 0
+    for ch, name in enumerate(SHUTTERS):
+        got = changes[name]
+        print(f"{name}: {len(got)} edges, {len(expected[ch])} expected")
+        for i in range(max(len(got), len(expected[ch]))):
+            want = expected[ch][i] if i < len(expected[ch]) else None
+            have = got[i] if i < len(got) else None
+            if want is None:
+                print(f"  extra {'rising' if have[1] else 'falling'} edge at {have[0] - offset:.4f}s")
+                failed += 1
+            elif have is None:
+                print(f"  missing {'rising' if want[1] else 'falling'} edge at {want[0]}s")
+                failed += 1
+            elif have[1] != want[1] or abs(have[0] - offset - want[0]) > args.tolerance:
+                print(f"  {'rising' if have[1] else 'falling'} edge at {have[0] - offset:.4f}s instead of "
+                      f"{'rising' if want[1] else 'falling'} at {want[0]}s")
+                failed += 1
+
+    if failed:
+        print(f"{failed} shutter edges are off")
+        sys.exit(1)
+    print("shutter edges OK")
+
+
+if __name__ == "__main__":
+    main()
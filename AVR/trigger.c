@@ -0,0 +1,218 @@
+/**
+ * Camera Shutter Control Project, trigger state machine
+ * By Electro707, 2023
+ *
+ * This is the state machine that counts down the trigger settings and drives the shutter lines.
+ * It only touches the hardware through the macros in board.h, so it can be compiled and driven
+ * on its own.
+ *
+ * Each of the two shutter lines can run as its own channel, with its own settings. Both channels get
+ * stepped one after the other on the same timer tick, so their edges line up to within microseconds.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <string.h>
+#include <avr/pgmspace.h>
+#include "board.h"
+#include "trigger.h"
+#include "ir.h"
+#include "flashsync.h"
+
+static uint8_t blinking_led_var = 0;       // Variable used for blinking an LED during pre-trigger time
+
+volatile uint8_t trigger_seq = 0;           // count of sequence steps, see TRIGGER_READ()
+
+// how busy each mode is, the sequence as a whole is in the busiest mode of its channels
+static const uint8_t mode_rank[] PROGMEM = {
+    [TRIGGER_MODE_STANDBY] = 0,
+    [TRIGGER_MODE_SCHEDULED] = 1,
+    [TRIGGER_MODE_WAITING_FOR_NEXT_PIC] = 2,
+    [TRIGGER_MODE_END] = 3,
+    [TRIGGER_MODE_ARM] = 4,
+    [TRIGGER_MODE_TRIGGERED] = 5,
+};
+
+/**
+ * Checks if the settings can be armed with
+ */
+bool trigger_settings_valid(const ShutterTriggerVars_s *settings){
+    // check that interval time, if npic != 0, fits trt and tt. The time to trigger takes at least one
+    // second even when it is 0, as the line has to be released for a second between pictures. With the
+    // flash-sync feedback, an interval of 0 waits as long as the camera needs instead
+    if(settings->n_pic != 0 && !FLASHSYNC_ADAPTIVE(settings->tmlps_interv)){
+        if(settings->tmlps_interv < (settings->trt + (settings->tt ? settings->tt : 1))){
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Steps the start delay and active window by a second, returns true if this second is in the window
+ *
+ * The first window opens start_delay seconds after arming, then windows open once every
+ * TRIGGER_WINDOW_PERIOD for window seconds. A window of 0 never closes
+ */
+static bool trigger_window_step(ShutterTriggerVars_s *cur, const ShutterTriggerVars_s *old){
+    if(cur->start_delay != 0){
+        if(--cur->start_delay == 0){
+            cur->window = old->window;
+        }
+        return false;
+    }
+    if(old->window != 0 && --cur->window == 0){
+        cur->start_delay = TRIGGER_WINDOW_PERIOD - old->window;
+    }
+    return true;
+}
+
+/**
+ * Arms the channels, returns the mode of the sequence, which stays in standby if any settings are invalid
+ *
+ * The first channel is always used. The others are only used if their shutter time isn't 0, otherwise
+ * their line gets driven along with the first channel, as a single camera needs both lines. They all
+ * share the start delay and window of the first channel.
+ * The timer ISR leaves the channels alone in standby, so this is safe to call from the main loop
+ */
+TriggerMode_e trigger_arm(TriggerChannel_s *channels){
+    TriggerChannel_s *first = &channels[0];
+    TriggerChannel_s *ch;
+
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        ch = &channels[i];
+        if((i == 0 || ch->cur.trt != 0) && !trigger_settings_valid(&ch->cur)){
+            return TRIGGER_MODE_STANDBY;
+        }
+    }
+
+    blinking_led_var = 0;
+    FLASHSYNC_START();
+    first->pins = TRIGGER_PIN(0);
+    for(uint8_t i=1;i<TRIGGER_N_CHANNELS;i++){
+        ch = &channels[i];
+        ch->cur.start_delay = first->cur.start_delay;
+        ch->cur.window = first->cur.window;
+        if(ch->cur.trt != 0){
+            ch->pins = TRIGGER_PIN(i);
+        } else {
+            ch->pins = 0;
+            first->pins |= TRIGGER_PIN(i);
+        }
+    }
+    // the modes get set last, as they start the sequence
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        ch = &channels[i];
+        memcpy(&ch->old, &ch->cur, sizeof(ch->old));
+        if(ch->pins){
+            ch->mode = ch->cur.start_delay ? TRIGGER_MODE_SCHEDULED : TRIGGER_MODE_ARM;
+        }
+    }
+    return first->mode;
+}
+
+/**
+ * Steps a channel by one second, returns its new mode. Only the first channel drives the LEDs and the
+ * IR LED
+ */
+static TriggerMode_e trigger_channel_step(TriggerChannel_s *ch, bool first){
+    TriggerMode_e mode = ch->mode;
+    ShutterTriggerVars_s *cur = &ch->cur;
+    const ShutterTriggerVars_s *old = &ch->old;
+    bool in_window = trigger_window_step(cur, old);
+
+    switch(mode){
+        case TRIGGER_MODE_WAITING_FOR_NEXT_PIC:
+            if(!in_window){
+                // the rest of the interval is dropped, the next picture gets taken once the next window opens
+                mode = TRIGGER_MODE_SCHEDULED;
+                break;
+            }
+            if(cur->tmlps_interv != 0){
+                cur->tmlps_interv--;
+                break;
+            }
+            /* fall through */
+        case TRIGGER_MODE_SCHEDULED:
+            if(!in_window){
+                break;
+            }
+            // start the next picture. This second already counts towards it, the same way the first
+            // second after arming does, so fall into the arming count-down. A picture that was started
+            // always gets finished, even if the window closes in the meantime
+            cur->trt = old->trt;
+            cur->tt = old->tt;
+            cur->tmlps_interv = old->tmlps_interv;
+            mode = TRIGGER_MODE_ARM;
+            /* fall through */
+        case TRIGGER_MODE_ARM:
+            if(first){
+                blinking_led_var = !blinking_led_var;
+                if(blinking_led_var){TURN_ON_CYAN;}else{TURN_OFF_ALL_LED;}
+            }
+            if(cur->tt != 0){cur->tt--;}
+            if(cur->tmlps_interv != 0){cur->tmlps_interv--;}
+            if(cur->tt == 0){
+                // TRIGGERED
+                TRIGGER_ON(ch->pins);
+                if(first){TRIGGER_IR(); FLASHSYNC_ARM();}
+                mode = TRIGGER_MODE_TRIGGERED;
+            }
+            break;
+        case TRIGGER_MODE_TRIGGERED:
+            if(first){TURN_ON_BLUE_LED;}
+            cur->trt--;
+            if(cur->tmlps_interv != 0){cur->tmlps_interv--;}
+            if(cur->trt == 0){
+                TRIGGER_OFF(ch->pins);
+                if(first){TURN_OFF_ALL_LED;}
+                if(first && FLASHSYNC_ADAPTIVE(old->tmlps_interv) && FLASHSYNC_MISSED(&cur->tmlps_interv)){
+                    // the camera didn't take the picture, so it gets taken again after a longer wait
+                    mode = TRIGGER_MODE_WAITING_FOR_NEXT_PIC;
+                } else if(cur->n_pic != 0){
+                    mode = TRIGGER_MODE_WAITING_FOR_NEXT_PIC;
+                    cur->n_pic--;
+                } else {
+                    // Trigger has stopped
+                    mode = TRIGGER_MODE_END;
+                }
+                
+            }
+            break;
+        case TRIGGER_MODE_END:
+            TRIGGER_OFF(ch->pins);
+            if(first){TURN_OFF_ALL_LED;}
+            memcpy(cur, old, sizeof(*cur));
+            mode = TRIGGER_MODE_STANDBY;
+            break;
+        default:
+            break;
+    }
+    return mode;
+}
+
+/**
+ * Steps every channel that is running by one second
+ *
+ * Returns the mode of the sequence as a whole, which is in standby once all channels are. This gets
+ * called from the timer ISR, so anything reading what it changes from the main loop has to do so with
+ * TRIGGER_READ()
+ */
+TriggerMode_e trigger_step(TriggerChannel_s *channels){
+    TriggerMode_e mode = TRIGGER_MODE_STANDBY;
+    TriggerChannel_s *ch;
+
+    for(uint8_t i=0;i<TRIGGER_N_CHANNELS;i++){
+        ch = &channels[i];
+        if(ch->mode != TRIGGER_MODE_STANDBY){
+            ch->mode = trigger_channel_step(ch, i == 0);
+        }
+        if(pgm_read_byte(&mode_rank[ch->mode]) > pgm_read_byte(&mode_rank[mode])){
+            mode = ch->mode;
+        }
+    }
+    trigger_seq++;
+    return mode;
+}
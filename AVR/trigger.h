@@ -0,0 +1,72 @@
+/**
+ * Camera Shutter Control Project, trigger state machine
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef TRIGGER_H
+#define TRIGGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum{
+    TRIGGER_MODE_STANDBY = 0,               // standby, doing nothing
+    TRIGGER_MODE_ARM,                       // arming, i.e waiting for trigger
+    TRIGGER_MODE_TRIGGERED,                 // triggered the camera
+    TRIGGER_MODE_WAITING_FOR_NEXT_PIC,      // waiting for the next picture in a multi picture arm
+    TRIGGER_MODE_END,                       // end of trigger
+    TRIGGER_MODE_SCHEDULED,                 // waiting for the start or the next active window
+}TriggerMode_e;
+
+#define TRIGGER_WINDOW_PERIOD 86400L        // active windows repeat once a day
+
+/**
+ * All trigger settings
+ */
+typedef struct{
+    int32_t tt;         // Time to Trigger
+    int32_t trt;        // Trigger Duration
+    int32_t n_pic;      // number of pictures for timelapse mode
+    int32_t tmlps_interv;   // The interval in seconds between different timelapse
+    int32_t start_delay;    // time until the first window opens. While running, the time until the next one does
+    int32_t window;         // length of the daily window pictures are taken in, 0 for always. While running, the time left in it
+}ShutterTriggerVars_s;
+
+#define TRIGGER_N_CHANNELS 2
+
+/**
+ * A shutter line, or both of them, with its own settings and sequence
+ */
+typedef struct{
+    TriggerMode_e mode;
+    uint8_t pins;               // the lines driven by this channel
+    ShutterTriggerVars_s cur;   // the running count-down of the settings, and the settings in standby
+    ShutterTriggerVars_s old;   // the settings as they were when arming
+}TriggerChannel_s;
+
+extern volatile uint8_t trigger_seq;
+
+/**
+ * Runs copy, which reads state that the timer ISR changes during a sequence, again until no sequence step
+ * happened while it ran. The ISR can't be interrupted by the main loop, so a count of steps is enough to
+ * tell, and interrupts never have to be disabled to get consistent values
+ */
+#define TRIGGER_READ(copy) do{ \
+        uint8_t _seq; \
+        do{ \
+            _seq = trigger_seq; \
+            __asm__ __volatile__("" ::: "memory"); \
+            copy; \
+            __asm__ __volatile__("" ::: "memory"); \
+        }while(_seq != trigger_seq); \
+    }while(0)
+
+bool trigger_settings_valid(const ShutterTriggerVars_s *settings);
+TriggerMode_e trigger_arm(TriggerChannel_s *channels);
+TriggerMode_e trigger_step(TriggerChannel_s *channels);
+
+#endif
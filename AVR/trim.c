@@ -0,0 +1,181 @@
+/**
+ * Camera Shutter Control Project, clock trim
+ * By Electro707, 2023
+ *
+ * All timing comes from the internal RC oscillator, which is only factory calibrated to a few percent.
+ * The drift is corrected in two steps: OSCCAL gets stepped when the clock is off by more than the fine
+ * trim can make up for, and the rest is made up by making some TIMER0 ticks a count longer or shorter.
+ * The fraction of a count left over is carried from tick to tick, so the correction is exact on average
+ * down to a ppm.
+ *
+ * The drift is measured against reference pulses on the trigger button, either pressed by hand or wired
+ * to something like a GPS receiver, on whole minutes. Both settings are kept in the EEPROM.
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/eeprom.h>
+#include "trim.h"
+#include "oled.h"
+
+#define TRIM_CHECK_SEED 0x5A
+
+/**
+ * The trim as stored in the EEPROM
+ */
+typedef struct{
+    uint8_t osccal;
+    int16_t ppm;
+    uint8_t check;
+}TrimSettings_s;
+
+static TrimSettings_s EEMEM trim_eeprom;
+
+int32_t trim_ppm = 0;
+
+static int16_t tick_ppm = 0;            // trim_ppm as used by the timer ISR
+static int16_t tick_frac = 0;           // part of a count carried over to the next tick, in ppm
+static uint8_t tick_top = TRIM_TIMER0_TOP;      // top of the running tick
+static uint16_t tick_start_counts = 0;  // free running TIMER0 count at the start of the running tick
+static volatile uint32_t trim_ticks = 0;
+static uint32_t measure_start;
+static bool measuring = false;
+
+static uint8_t trim_check(const TrimSettings_s *settings){
+    return TRIM_CHECK_SEED ^ settings->osccal ^ (uint8_t)settings->ppm ^ (uint8_t)(settings->ppm >> 8);
+}
+
+/**
+ * Loads the trim from the EEPROM, the factory calibration is kept if it was never saved
+ */
+void trim_load(void){
+    TrimSettings_s settings;
+
+    eeprom_read_block(&settings, &trim_eeprom, sizeof(settings));
+    if(settings.check != trim_check(&settings)){
+        return;
+    }
+    OSCCAL = settings.osccal;
+    trim_ppm = settings.ppm;
+    trim_apply();
+}
+
+/**
+ * Saves the trim to the EEPROM, only writing the bytes that changed
+ */
+void trim_save(void){
+    TrimSettings_s settings;
+
+    settings.osccal = OSCCAL;
+    settings.ppm = trim_ppm;
+    settings.check = trim_check(&settings);
+    eeprom_update_block(&settings, &trim_eeprom, sizeof(settings));
+}
+
+/**
+ * Hands the trim over to the timer ISR
+ */
+void trim_apply(void){
+    uint8_t sreg = SREG;
+
+    cli();
+    tick_ppm = trim_ppm;
+    SREG = sreg;
+}
+
+/**
+ * Sets the length of the tick that just started, called first thing from the timer ISR
+ */
+void trim_tick(void){
+    uint8_t top = TRIM_TIMER0_TOP;
+
+    trim_ticks++;
+    tick_start_counts += tick_top + 1;
+    tick_frac += tick_ppm;
+    while(tick_frac >= TRIM_PPM_PER_COUNT){
+        tick_frac -= TRIM_PPM_PER_COUNT;
+        top++;
+    }
+    while(tick_frac < 0){
+        tick_frac += TRIM_PPM_PER_COUNT;
+        top--;
+    }
+    // the counter only just started over, so it is still well below the new top
+    OCR0A = top;
+    tick_top = top;
+}
+
+/**
+ * Returns a free running count of TIMER0 counts, as they are without the trim. Call with interrupts off
+ */
+uint16_t trim_counts(void){
+    uint8_t tcnt = TCNT0L;
+    uint16_t counts = tick_start_counts;
+
+    // the counter already started the next tick, but the timer ISR hasn't run yet
+    if((TIFR & (1 << OCF0A)) && tcnt < TRIM_TIMER0_TOP / 2){
+        counts += tick_top + 1;
+    }
+    return counts + tcnt;
+}
+
+/**
+ * Takes a reference pulse, which have to come on whole minutes
+ *
+ * The first pulse starts a measurement, the next one ends it and corrects the trim by how far the
+ * ticks counted in between were from the nearest whole number of minutes. So the clock has to be
+ * within 30 seconds of the reference, and the longer the measurement, the better: with the 8ms ticks,
+ * an hour is good to about 2ppm.
+ */
+void trim_reference_pulse(void){
+    uint8_t sreg = SREG;
+    uint32_t now, elapsed, minutes;
+    int32_t ppm;
+
+    cli();
+    now = trim_ticks;
+    SREG = sreg;
+
+    if(!measuring){
+        measure_start = now;
+        measuring = true;
+        return;
+    }
+    elapsed = now - measure_start;
+    minutes = (elapsed + TRIM_TICKS_PER_MINUTE/2) / TRIM_TICKS_PER_MINUTE;
+    if(minutes == 0){
+        // too short to tell, so this starts the measurement over
+        measure_start = now;
+        return;
+    }
+    measuring = false;
+
+    // ticks off per tick in ppm, 1000000/7500 being 400/3. The difference is at most half a minute
+    // of ticks, so this can't overflow
+    ppm = trim_ppm + ((int32_t)(elapsed - minutes * TRIM_TICKS_PER_MINUTE) * 400) / (int32_t)(3 * minutes);
+
+    // OSCCAL steps are far coarser than the fine trim, and differ from chip to chip, so it is only
+    // stepped by one and the next measurement takes care of the rest
+    if(ppm > TRIM_PPM_MAX){
+        OSCCAL--;
+        ppm = TRIM_PPM_MAX;
+    } else if(ppm < -TRIM_PPM_MAX){
+        OSCCAL++;
+        ppm = -TRIM_PPM_MAX;
+    }
+    trim_ppm = ppm;
+    trim_apply();
+}
+
+/**
+ * Draws the trim page text, except for the ppm field which is drawn by the menu
+ */
+void trim_draw_page(void){
+    oled_send_text_P(PSTR("CLOCK TRIM"), 0);
+    oled_send_text_P(PSTR("Press trigger on\nwhole minutes"), 4);
+    oled_send_text_P(measuring ? PSTR("Measuring") : PSTR("Ready    "), 7);
+}
@@ -0,0 +1,35 @@
+/**
+ * Camera Shutter Control Project, clock trim
+ * By Electro707, 2023
+ *
+ * This program is free software: you can redistribute it and/or modify it under the terms of the
+ * GNU General Public License as published by the Free Software Foundation, either version 3 of the
+ * License, or (at your option) any later version.
+ */
+
+#ifndef TRIM_H
+#define TRIM_H
+
+#include <avr/io.h>
+#include <stdbool.h>
+
+#define TRIM_TIMER0_TOP 249             // 8Mhz / 256 / (249+1) = 125 Hz
+#define TRIM_PPM_PER_COUNT 4000         // one TIMER0 count more or less per tick, in ppm
+#define TRIM_PPM_MAX 20000L             // a tick can be trimmed by up to 5 counts either way
+#define TRIM_TICKS_PER_MINUTE 7500UL
+
+/**
+ * How fast the oscillator runs in ppm, positive being fast. Gets edited from the trim page, call
+ * trim_apply() after changing it
+ */
+extern int32_t trim_ppm;
+
+void trim_load(void);
+void trim_save(void);
+void trim_apply(void);
+void trim_tick(void);
+uint16_t trim_counts(void);
+void trim_reference_pulse(void);
+void trim_draw_page(void);
+
+#endif